@@ -0,0 +1,49 @@
+#include "CompactLock.h"
+
+#include <system_error>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace Caelus::Utilities;
+
+uint32_t CompactLock::nextOwner(){
+    //24 bits of thread ids, only threads that are 16M thread creations apart
+    //can share one
+    static std::atomic<uint32_t> threads(0);
+    return (threads.fetch_add(1, std::memory_order_relaxed) % (OWNER >> 8) + 1) << 8;
+}
+
+void CompactLock::tooDeep(){
+    throw std::system_error(std::make_error_code(std::errc::resource_unavailable_try_again),
+                            "CompactLock held too many times by one thread");
+}
+
+void CompactLock::lockContended(uint32_t self){
+    //once a thread has slept it can not know whether others are still waiting,
+    //so it takes the lock with WAITERS set and wakes the next one on unlock
+    uint32_t desired = self | 1;
+    for (;;){
+        uint32_t state = 0;
+        if (_state.compare_exchange_strong(state, desired, std::memory_order_acquire))
+            return;
+        if (!(state & WAITERS) && !_state.compare_exchange_weak(state, state | WAITERS, std::memory_order_relaxed))
+            continue;
+#ifdef __linux__
+        syscall(SYS_futex, &_state, FUTEX_WAIT_PRIVATE, state | WAITERS, NULL, NULL, 0);
+#else
+        std::this_thread::yield();
+#endif
+        desired = self | WAITERS | 1;
+    }
+}
+
+void CompactLock::wake(){
+#ifdef __linux__
+    syscall(SYS_futex, &_state, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#endif
+}
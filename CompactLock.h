@@ -0,0 +1,122 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2014 Alexander Nilsson
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef COMPACTLOCK_H_INCLUDED
+#define COMPACTLOCK_H_INCLUDED
+
+#include <atomic>
+#include <stdint.h>
+
+namespace Caelus {
+    namespace Utilities {
+
+        /**
+         * CompactLock class, a recursive mutex in 4 bytes. The lock word holds the
+         * owning thread, a flag for waiting threads and the recursion depth, waiting
+         * threads sleep on a futex on Linux and yield elsewhere.
+         * It satisfies the Lockable requirements, so it works with std::lock_guard.
+         * Limits of the compact state:
+         * - A thread can hold the lock at most 127 times at once (MAX_DEPTH), like
+         *   std::recursive_mutex lock() then throws std::system_error and try_lock()
+         *   returns false.
+         * - Threads get 24 bit ids in the order they first lock a CompactLock, the
+         *   ids wrap around after 16M threads, so a thread could be taken for the
+         *   owner of a lock held by a thread that started 16M threads earlier and
+         *   is still alive. Programs that create that many threads while keeping
+         *   locks held across them should use std::recursive_mutex instead.
+         */
+        class CompactLock {
+        public:
+            /** The number of times a thread can hold the lock at once **/
+            enum { MAX_DEPTH = 0x7F };
+
+            CompactLock() : _state(0) {}
+
+            void lock(){
+                uint32_t self = owner();
+                uint32_t state = 0;
+                if (_state.compare_exchange_strong(state, self | 1, std::memory_order_acquire))
+                    return;
+                if ((state & OWNER) == self){
+                    //one more would carry into the WAITERS bit
+                    if ((state & DEPTH) == MAX_DEPTH)
+                        tooDeep();
+                    _state.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                lockContended(self);
+            }
+
+            bool try_lock(){
+                uint32_t self = owner();
+                uint32_t state = 0;
+                if (_state.compare_exchange_strong(state, self | 1, std::memory_order_acquire))
+                    return true;
+                if ((state & OWNER) == self){
+                    if ((state & DEPTH) == MAX_DEPTH)
+                        return false;
+                    _state.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+                return false;
+            }
+
+            void unlock(){
+                //only the owner changes the depth, other threads only set WAITERS
+                if ((_state.load(std::memory_order_relaxed) & DEPTH) > 1){
+                    _state.fetch_sub(1, std::memory_order_release);
+                    return;
+                }
+                if (_state.exchange(0, std::memory_order_release) & WAITERS)
+                    wake();
+            }
+
+        private:
+            enum : uint32_t {
+                DEPTH = 0x7F,
+                WAITERS = 0x80,
+                OWNER = 0xFFFFFF00
+            };
+
+            //the calling thread, shifted into the OWNER bits
+            static uint32_t owner(){
+                static thread_local uint32_t self = nextOwner();
+                return self;
+            }
+
+            static uint32_t nextOwner();
+            static void tooDeep();
+            void lockContended(uint32_t self);
+            void wake();
+
+            //never copied
+            CompactLock(const CompactLock&);
+            CompactLock& operator= (const CompactLock&);
+
+        private:
+            std::atomic<uint32_t> _state;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,291 @@
+#include "FrozenSecureString.h"
+
+#include <string.h>
+#include <algorithm>
+
+#ifdef SECURESTRING_THREADSAFE
+#include <mutex>
+#endif
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+uint32_t crc32buf(const char *buf, size_t len);
+
+using namespace Caelus::Utilities;
+
+FrozenSecureString::FrozenSecureString(const SecureString& src){
+#ifdef SECURESTRING_THREADSAFE
+    std::lock_guard<__securestring_lock_type> lock(src.objectLock());
+#endif
+    ssnr len = ((ssnr)*src._key) ^ src._length;
+    ssnr keylen = keySize(len);
+    _resource = SecureString::defaultMemoryResource();
+    _block = SecureString::allocateBytes(blockSize(len), SecureString::FROZEN, _resource);
+    _mapped = false;
+
+    //the contents are already obfuscated, so the key and data are copied as is
+    //(the source arrays always hold at least keySize(len) bytes)
+    memcpy(_block + 2 * sizeof(ssnr), src._key, keylen);
+    memcpy(_block + 2 * sizeof(ssnr) + keylen, src._data, len);
+
+    ssnr header[2] = { len ^ keyword(), src._checksum };
+    memcpy(_block, header, sizeof(header));
+}
+
+FrozenSecureString::FrozenSecureString(const FrozenSecureString& src){
+    ssnr size = blockSize(src.length());
+    _resource = SecureString::defaultMemoryResource();
+    _block = SecureString::allocateBytes(size, SecureString::FROZEN, _resource);
+    _mapped = false;
+    memcpy(_block, src._block, size);
+}
+
+FrozenSecureString::~FrozenSecureString(void){
+    release();
+}
+
+FrozenSecureString& FrozenSecureString::operator= (const FrozenSecureString& other){
+    if (this != &other){
+        ssnr size = blockSize(other.length());
+        ssarr block = SecureString::allocateBytes(size, SecureString::FROZEN, _resource);
+        memcpy(block, other._block, size);
+        release();
+        _block = block;
+        _mapped = false;
+    }
+    return *this;
+}
+
+void FrozenSecureString::release(){
+    ssnr size = blockSize(length());
+#ifdef __linux__
+    if (_mapped){
+        //read-only, and shared with the sender
+        munmap(_block, size);
+        _block = NULL;
+        return;
+    }
+#endif
+    //Zero out all data
+    memset(_block, 0, size);
+    SecureString::releaseBytes(_block, size, SecureString::FROZEN, _resource);
+    _block = NULL;
+}
+
+FrozenSecureString::ssnr FrozenSecureString::keySize(ssnr length){
+    //the key must at least be able to mask the length
+    return std::max(length, (ssnr)sizeof(ssnr));
+}
+
+FrozenSecureString::ssnr FrozenSecureString::blockSize(ssnr length){
+    return 2 * sizeof(ssnr) + keySize(length) + length;
+}
+
+FrozenSecureString::ssnr FrozenSecureString::keyword() const{
+    ssnr word;
+    memcpy(&word, key(), sizeof(ssnr));
+    return word;
+}
+
+FrozenSecureString::c_ssarr FrozenSecureString::key() const{
+    return _block + 2 * sizeof(ssnr);
+}
+
+FrozenSecureString::c_ssarr FrozenSecureString::data() const{
+    return key() + keySize(length());
+}
+
+FrozenSecureString::ssnr FrozenSecureString::length() const{
+    ssnr len;
+    memcpy(&len, _block, sizeof(ssnr));
+    return len ^ keyword();
+}
+
+FrozenSecureString::ssnr FrozenSecureString::checksum() const{
+    ssnr sum;
+    memcpy(&sum, _block + sizeof(ssnr), sizeof(ssnr));
+    return sum;
+}
+
+FrozenSecureString::ssbyte FrozenSecureString::at(ssnr pos) const{
+    if (pos < length())
+        return key()[pos] ^ data()[pos];
+    else
+        return 0;
+}
+
+FrozenSecureString::ssnr FrozenSecureString::getUnsecureString(ssarr buffer, ssnr size) const{
+    if (size == 0)
+        return 0;
+    ssnr len = std::min(length(), size - 1);
+    c_ssarr k = key();
+    c_ssarr d = data();
+    for (ssnr i = 0; i < len; i++){
+        buffer[i] = k[i] ^ d[i];
+    }
+    buffer[len] = '\0';
+    return len;
+}
+
+bool FrozenSecureString::equals(const FrozenSecureString& s2) const{
+    if (s2.length() != length()){
+        return false;
+    }
+    return checksum() == s2.checksum();
+}
+
+bool FrozenSecureString::equals(const SecureString& s2) const{
+    if (s2.length() != length()){
+        return false;
+    }
+    return checksum() == s2.checksum();
+}
+
+bool FrozenSecureString::equals(const char* s2) const{
+    ssnr len = length();
+    if (strlen(s2) != len){
+        return false;
+    }
+    return checksum() == crc32buf(s2, len);
+}
+
+#ifdef __linux__
+bool FrozenSecureString::send(int socket) const{
+    int fd = memfd_create("securestring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0)
+        return false;
+
+    //write the block as is, it is already obfuscated
+    ssnr size = blockSize(length());
+    bool ok = ftruncate(fd, size) == 0;
+    for (ssnr written = 0; ok && written < size;){
+        ssize_t n = pwrite(fd, _block + written, size - written, written);
+        if (n < 0 && errno == EINTR)
+            continue;
+        ok = n > 0;
+        written += ok ? (ssnr)n : 0;
+    }
+    ok = ok && fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == 0;
+
+    if (ok){
+        char payload = 0;
+        struct iovec iov;
+        iov.iov_base = &payload;
+        iov.iov_len = 1;
+        union {
+            char buffer[CMSG_SPACE(sizeof(int))];
+            struct cmsghdr align;
+        } control;
+        memset(&control, 0, sizeof(control));
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buffer;
+        msg.msg_controllen = sizeof(control.buffer);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+        ssize_t n;
+        do {
+            n = sendmsg(socket, &msg, MSG_NOSIGNAL);
+        } while (n < 0 && errno == EINTR);
+        ok = n == 1;
+    }
+    close(fd);
+    return ok;
+}
+
+bool FrozenSecureString::receive(int socket){
+    char payload;
+    struct iovec iov;
+    iov.iov_base = &payload;
+    iov.iov_len = 1;
+    union {
+        char buffer[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buffer;
+    msg.msg_controllen = sizeof(control.buffer);
+    ssize_t n;
+    do {
+        n = recvmsg(socket, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0)
+        return false;
+
+    //take over every descriptor that came with the message, so that none of
+    //them leaks when the message is rejected, only a single one is accepted
+    int fd = -1;
+    bool valid = n == 1 && (msg.msg_flags & MSG_CTRUNC) == 0;
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)){
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS){
+            valid = false;
+            continue;
+        }
+        size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (size_t i = 0; i < count; i++){
+            int received;
+            memcpy(&received, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+            if (fd < 0 && cmsg->cmsg_len == CMSG_LEN(sizeof(int))){
+                fd = received;
+            } else {
+                close(received);
+                valid = false;
+            }
+        }
+    }
+    if (fd < 0)
+        return false;
+    if (!valid){
+        close(fd);
+        return false;
+    }
+
+    //the sender must not be able to change the block after it has been checked,
+    //F_GET_SEALS fails for anything but a memfd, e.g. a regular file
+    int required = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL;
+    int seals = fcntl(fd, F_GET_SEALS);
+    struct stat st;
+    bool ok = seals >= 0 && (seals & required) == required &&
+              fstat(fd, &st) == 0 && st.st_size >= (off_t)blockSize(0);
+    ssarr block = NULL;
+    if (ok){
+        void* mapping = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ok = mapping != MAP_FAILED;
+        block = (ssarr)mapping;
+    }
+    close(fd);
+    if (!ok)
+        return false;
+
+    //the header must describe exactly the block that was received
+    ssnr header[2];
+    ssnr word;
+    memcpy(header, block, sizeof(header));
+    memcpy(&word, block + 2 * sizeof(ssnr), sizeof(ssnr));
+    ssnr len = header[0] ^ word;
+    if (len > (ssnr)st.st_size || (off_t)blockSize(len) != st.st_size){
+        munmap(block, st.st_size);
+        return false;
+    }
+
+    release();
+    _block = block;
+    _mapped = true;
+    return true;
+}
+#endif
@@ -0,0 +1,170 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2014 Alexander Nilsson
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef FROZENSECURESTRING_H_INCLUDED
+#define FROZENSECURESTRING_H_INCLUDED
+
+#include "SecureString.h"
+
+namespace Caelus {
+    namespace Utilities {
+
+        /**
+         * FrozenSecureString class, an immutable snapshot of a SecureString.
+         * The string is stored exactly sized in a single block, together with its
+         * key, length and checksum. Besides the block pointer the object only holds
+         * the memory resource the block came from and whether the block is a
+         * mapping received with receive().
+         * The contents are only replaced by operator= and receive(), so reading
+         * needs no locking and any number of threads may read it at the same time.
+         * OBS! operator= and receive() release the old block, they must not run
+         * while other threads read the object.
+         * PLEASE NOTE THAT THIS IS IN NO WAY CRYTOGRAPHICALLY SECURE, IT ONLY PREVENTS
+         * THE STRING FROM BEING STORED IN PLAINTEXT.
+         */
+        class FrozenSecureString {
+        public:
+            typedef SecureString::ssnr ssnr;
+            typedef SecureString::ssbyte ssbyte;
+            typedef SecureString::ssarr ssarr;
+            typedef SecureString::c_ssarr c_ssarr;
+
+        public:
+
+            /**
+             * Constructor:
+             * Creates a frozen copy of the current contents of src.
+             * @param src - The string to freeze
+             */
+            FrozenSecureString(const SecureString& src);
+
+            /** Copy-constructor **/
+            FrozenSecureString(const FrozenSecureString&);
+
+            /** Destructor **/
+            ~FrozenSecureString(void);
+
+            /**
+             * Assignment operator, must not run while other threads read this object
+             */
+            FrozenSecureString& operator= (const FrozenSecureString& other);
+
+            /**
+             * This returns the length of the string, excluding trailing null character
+             * @return length of string
+             */
+            ssnr length() const;
+
+            /**
+             * This returns a single character at position pos of the string.
+             * This never allocates memory.
+             * @param pos - the position in the string to return
+             * @return character at position pos, 0 on failure
+             */
+            ssbyte at(ssnr pos) const;
+
+            /**
+             * This writes a plaintext copy of the string into buffer, followed by a
+             * trailing null character. At most size - 1 characters are written.
+             * The caller is responsible for wiping the buffer when it is no
+             * longer needed. This never allocates memory.
+             * @param buffer - the buffer to write to
+             * @param size - the size of the buffer in bytes
+             * @return the number of characters written, excluding the null character
+             */
+            ssnr getUnsecureString(ssarr buffer, ssnr size) const;
+
+            /**
+             * This returns true if the argument contains an equal string
+             * @param s2 - the string to compare with
+             * @return true - if strings are equal
+             */
+            bool equals(const FrozenSecureString& s2) const;
+
+            /**
+             * This returns true if the argument contains an equal string
+             * @param s2 - the string to compare with
+             * @return true - if strings are equal
+             */
+            bool equals(const SecureString& s2) const;
+
+            /**
+             * This returns true if the argument contains an equal string
+             * @param s2 - the string to compare with
+             * @return true - if strings are equal
+             */
+            bool equals(const char* s2) const;
+
+            bool operator==(const FrozenSecureString& other) const
+            {
+                return equals(other);
+            }
+
+            /**
+             * This returns the checksum of the string
+             * @return the corresponding checksum of the string
+             */
+            ssnr checksum() const;
+
+#ifdef __linux__
+            /**
+             * This sends the string to another process over a Unix domain socket.
+             * The obfuscated contents are written to a sealed memfd that is passed
+             * with SCM_RIGHTS, the plaintext is never written to the socket.
+             * @param socket - a connected Unix domain socket
+             * @return false on failure
+             */
+            bool send(int socket) const;
+
+            /**
+             * This replaces the contents with a string received with send(). The
+             * memfd is mapped read-only and used directly, without copying. It is
+             * rejected unless it is a memfd that is sealed against writes, resizing
+             * and further changes to its seals. Like operator= it must not run while
+             * other threads read this object.
+             * @param socket - a connected Unix domain socket
+             * @return false on failure, the contents are then unchanged
+             */
+            bool receive(int socket);
+#endif
+
+        private:
+            static ssnr keySize(ssnr length);
+            static ssnr blockSize(ssnr length);
+            ssnr keyword() const;
+            c_ssarr key() const;
+            c_ssarr data() const;
+            void release();
+
+        private:
+            //[length ^ keyword][checksum][key][data]
+            ssarr _block;
+            //the resource the block is allocated from, the default one at construction
+            MemoryResource* _resource;
+            //the block is a read-only mapping from receive(), not a heap block
+            bool _mapped;
+        };
+    }
+}
+
+#endif
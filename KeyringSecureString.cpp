@@ -0,0 +1,207 @@
+#include "KeyringSecureString.h"
+
+#ifdef __linux__
+#include "FrozenSecureString.h"
+
+#include <condition_variable>
+#include <linux/keyctl.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace Caelus::Utilities;
+
+/**
+ * A single background thread that wipes the cached values of all instances when
+ * their time is up. The deadlines are kept in a TimerWheel with RESOLUTION ms
+ * ticks, the thread only wakes up while there are deadlines pending.
+ * Instances schedule and cancel their deadline while holding their own lock, so
+ * the thread only tries to take that lock, and retries a tick later when the
+ * instance is busy.
+ */
+class KeyringSecureString::CacheReaper {
+public:
+    enum { RESOLUTION = 10 };
+
+    static CacheReaper& instance(){
+        //never destroyed, instances with static storage duration may outlive it otherwise
+        static CacheReaper* reaper = new CacheReaper();
+        return *reaper;
+    }
+
+    void schedule(CacheDeadline* deadline, std::chrono::milliseconds timeout){
+        std::lock_guard<std::mutex> lock(_lock);
+        if (!_started){
+            std::thread(&CacheReaper::run, this).detach();
+            _started = true;
+        }
+        _wheel.schedule(deadline, currentTick() + (timeout.count() + RESOLUTION - 1) / RESOLUTION);
+        _wakeup.notify_one();
+    }
+
+    void cancel(CacheDeadline* deadline){
+        std::lock_guard<std::mutex> lock(_lock);
+        _wheel.cancel(deadline);
+    }
+
+private:
+    CacheReaper() : _wheel(currentTick()), _started(false) {}
+
+    static uint64_t currentTick(){
+        using namespace std::chrono;
+        return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count() / RESOLUTION;
+    }
+
+    static void onExpire(TimerWheel::Node* node, void* context){
+        CacheReaper* reaper = (CacheReaper*)context;
+        CacheDeadline* deadline = static_cast<CacheDeadline*>(node);
+        if (!deadline->owner->expireCache())
+            reaper->_wheel.schedule(deadline, reaper->_wheel.now() + 1);
+    }
+
+    void run(){
+        std::unique_lock<std::mutex> lock(_lock);
+        for (;;){
+            while (_wheel.size() == 0){
+                _wakeup.wait(lock);
+            }
+            _wakeup.wait_for(lock, std::chrono::milliseconds(RESOLUTION));
+            _wheel.advance(currentTick(), onExpire, this);
+        }
+    }
+
+    std::mutex _lock;
+    std::condition_variable _wakeup;
+    TimerWheel _wheel;
+    bool _started;
+};
+
+KeyringSecureString::KeyringSecureString(const SecureString& value, const std::string& description,
+                                         unsigned int cacheTimeout, int32_t keyring)
+    : _serial(-1), _description(description), _keyring(keyring), _cacheTimeout(cacheTimeout), _cached(false)
+{
+    _deadline.owner = this;
+    SecureString::ssnr length;
+    char* payload = decode(value, length);
+    long serial = syscall(SYS_add_key, "user", description.c_str(), payload, (size_t)length, keyring);
+    wipe(payload, length);
+    if (serial >= 0)
+        _serial = (int32_t)serial;
+}
+
+KeyringSecureString::~KeyringSecureString(void){
+    std::lock_guard<std::mutex> lock(_lock);
+    if (_serial >= 0){
+        //invalidate removes the key from all keyrings at once, revoke is the
+        //fallback for kernels before 3.5
+        if (syscall(SYS_keyctl, KEYCTL_INVALIDATE, _serial) != 0)
+            syscall(SYS_keyctl, KEYCTL_REVOKE, _serial);
+    }
+    if (_cached)
+        CacheReaper::instance().cancel(&_deadline);
+    //the SecureString destructor wipes the cache
+}
+
+bool KeyringSecureString::read(SecureString& value){
+    std::lock_guard<std::mutex> lock(_lock);
+    if (_serial < 0)
+        return false;
+    if (_cached && std::chrono::steady_clock::now() < _cacheExpires){
+        value.assign(_cache);
+        return true;
+    }
+
+    //the payload may have been updated by someone else, retry until it fits
+    SecureString::ssnr size = 64;
+    for (;;){
+        char* buffer = new char[size + 1];
+        long n = syscall(SYS_keyctl, KEYCTL_READ, _serial, buffer, (size_t)size);
+        if (n < 0){
+            wipe(buffer, size);
+            return false;
+        }
+        if ((SecureString::ssnr)n <= size){
+            buffer[n] = '\0';
+            try {
+                value.assign(buffer, (SecureString::ssnr)n, false, true);
+            } catch (...) {
+                wipe(buffer, size);
+                throw;
+            }
+            wipe(buffer, size);
+            break;
+        }
+        wipe(buffer, size);
+        size = (SecureString::ssnr)n;
+    }
+
+    if (_cacheTimeout.count() > 0){
+        _cache.assign(value);
+        _cached = true;
+        _cacheExpires = std::chrono::steady_clock::now() + _cacheTimeout;
+        CacheReaper::instance().schedule(&_deadline, _cacheTimeout);
+    }
+    return true;
+}
+
+bool KeyringSecureString::update(const SecureString& value){
+    std::lock_guard<std::mutex> lock(_lock);
+    if (_serial < 0)
+        return false;
+    SecureString::ssnr length;
+    char* payload = decode(value, length);
+    //KEYCTL_UPDATE is limited to a page, adding a key with the same type and
+    //description to the same keyring updates it in place without that limit
+    long serial = syscall(SYS_add_key, "user", _description.c_str(), payload, (size_t)length, _keyring);
+    wipe(payload, length);
+    clearCache();
+    return serial == _serial;
+}
+
+void KeyringSecureString::invalidateCache(){
+    std::lock_guard<std::mutex> lock(_lock);
+    clearCache();
+}
+
+bool KeyringSecureString::valid() const{
+    std::lock_guard<std::mutex> lock(_lock);
+    return _serial >= 0;
+}
+
+int32_t KeyringSecureString::serial() const{
+    std::lock_guard<std::mutex> lock(_lock);
+    return _serial;
+}
+
+char* KeyringSecureString::decode(const SecureString& value, SecureString::ssnr& length){
+    //decode through a frozen copy, so that value does not get a plaintext copy
+    FrozenSecureString frozen(value);
+    length = frozen.length();
+    char* buffer = new char[length + 1];
+    frozen.getUnsecureString(buffer, length + 1);
+    return buffer;
+}
+
+void KeyringSecureString::clearCache(){
+    if (!_cached)
+        return;
+    CacheReaper::instance().cancel(&_deadline);
+    _cache.assign("");
+    _cached = false;
+}
+
+bool KeyringSecureString::expireCache(){
+    //called by the CacheReaper with its lock held, see CacheReaper
+    if (!_lock.try_lock())
+        return false;
+    _cache.assign("");
+    _cached = false;
+    _lock.unlock();
+    return true;
+}
+
+void KeyringSecureString::wipe(char* buffer, SecureString::ssnr length){
+    SecureString::wipeMemory(buffer, length);
+    delete[] buffer;
+}
+#endif
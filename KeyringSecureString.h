@@ -0,0 +1,132 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2014 Alexander Nilsson
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef KEYRINGSECURESTRING_H_INCLUDED
+#define KEYRINGSECURESTRING_H_INCLUDED
+
+#include "SecureString.h"
+#include "TimerWheel.h"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+
+//the kernel keyring only exists on Linux, elsewhere the class is left out
+#ifdef __linux__
+namespace Caelus {
+    namespace Utilities {
+
+        /**
+         * KeyringSecureString class, a secret kept in the Linux kernel keyring
+         * instead of in process memory. The payload is stored as a "user" key and
+         * read back with keyctl when needed. To make repeated reads cheap, the
+         * last value read is kept as an obfuscated SecureString for a short time.
+         * When that time is up a background thread wipes it, shared by all
+         * instances, and the next read goes to the kernel again.
+         * The key is invalidated when the object is destroyed.
+         * This class is thread safe.
+         */
+        class KeyringSecureString {
+        public:
+
+            /**
+             * Constructor:
+             * Stores value in the keyring. Check valid() to see if it succeeded.
+             * @param value - the secret, at most 32767 bytes
+             * @param description - the description of the key in the keyring
+             * @param cacheTimeout - milliseconds a value read from the keyring is
+             * kept in process, it is wiped at most 10 ms later, 0 disables the cache
+             * @param keyring - the keyring to add the key to, the process keyring
+             * by default
+             */
+            KeyringSecureString(const SecureString& value, const std::string& description,
+                                unsigned int cacheTimeout = 1000, int32_t keyring = -2);
+
+            /** Destructor **/
+            ~KeyringSecureString(void);
+
+            /**
+             * This copies the secret into value, from the cache if it is still fresh
+             * and from the keyring otherwise.
+             * @param value - receives the secret
+             * @return false on failure, e.g. if the key has been revoked
+             */
+            bool read(SecureString& value);
+
+            /**
+             * This replaces the secret in the keyring, and wipes the cache.
+             * @param value - the new secret
+             * @return false on failure
+             */
+            bool update(const SecureString& value);
+
+            /**
+             * This wipes the cached copy, the next read goes to the keyring.
+             */
+            void invalidateCache();
+
+            /**
+             * This returns true if the key was added to the keyring
+             * @return true if valid
+             */
+            bool valid() const;
+
+            /**
+             * This returns the serial number of the key, -1 if it is not valid
+             * @return key serial number
+             */
+            int32_t serial() const;
+
+        private:
+            //the node that is scheduled in the CacheReaper while a value is cached
+            struct CacheDeadline : TimerWheel::Node {
+                KeyringSecureString* owner;
+            };
+            class CacheReaper;
+
+            static char* decode(const SecureString& value, SecureString::ssnr& length);
+            static void wipe(char* buffer, SecureString::ssnr length);
+            void clearCache();
+            bool expireCache();
+
+            //never copied
+            KeyringSecureString(const KeyringSecureString&);
+            KeyringSecureString& operator= (const KeyringSecureString&);
+
+        private:
+            mutable std::mutex _lock;
+            int32_t _serial;
+            std::string _description;
+            int32_t _keyring;
+            std::chrono::milliseconds _cacheTimeout;
+            SecureString _cache;
+            bool _cached;
+            std::chrono::steady_clock::time_point _cacheExpires;
+            CacheDeadline _deadline;
+        };
+    }
+}
+
+#endif
+
+#endif
@@ -0,0 +1,109 @@
+#include "LazySecureString.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace Caelus::Utilities;
+
+LazySecureString::LazySecureString(Provider provider, void* context)
+    : _provider(provider), _context(context), _fd(-1), _value(NULL), _failed(false)
+{
+}
+
+LazySecureString::LazySecureString(const std::string& path)
+    : _provider(readFile), _context(this), _path(path), _fd(-1), _value(NULL), _failed(false)
+{
+}
+
+LazySecureString::LazySecureString(int fd)
+    : _provider(readDescriptor), _context(this), _fd(fd), _value(NULL), _failed(false)
+{
+}
+
+LazySecureString::~LazySecureString(void){
+    //the SecureString destructor wipes the secret
+    delete _value.load();
+}
+
+SecureString& LazySecureString::get(){
+    SecureString* value = _value.load(std::memory_order_acquire);
+    if (value == NULL){
+        std::call_once(_once, &LazySecureString::load, this);
+        value = _value.load(std::memory_order_acquire);
+    }
+    return *value;
+}
+
+bool LazySecureString::loaded() const{
+    return _value.load(std::memory_order_acquire) != NULL;
+}
+
+bool LazySecureString::failed() const{
+    return loaded() && _failed;
+}
+
+void LazySecureString::load(){
+    SecureString* value = new SecureString();
+    bool ok;
+    try {
+        ok = _provider(*value, _context);
+    } catch (...) {
+        //the destructor wipes what was loaded so far, the next access tries again
+        delete value;
+        throw;
+    }
+    if (!ok){
+        //don't keep a partially loaded secret
+        value->assign("");
+        _failed = true;
+    }
+    _value.store(value, std::memory_order_release);
+}
+
+bool LazySecureString::readFile(SecureString& value, void* context){
+    LazySecureString* lazy = (LazySecureString*)context;
+    int fd;
+    do {
+        fd = open(lazy->_path.c_str(), O_RDONLY | O_CLOEXEC);
+    } while (fd < 0 && errno == EINTR);
+    if (fd < 0)
+        return false;
+    bool ok;
+    try {
+        ok = readAll(value, fd);
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    close(fd);
+    return ok;
+}
+
+bool LazySecureString::readDescriptor(SecureString& value, void* context){
+    LazySecureString* lazy = (LazySecureString*)context;
+    return readAll(value, lazy->_fd);
+}
+
+bool LazySecureString::readAll(SecureString& value, int fd){
+    SecureString::ssbyte buffer[4096];
+    bool ok = true;
+    for (;;){
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0){
+            ok = (n == 0);
+            break;
+        }
+        try {
+            value.append(buffer, (SecureString::ssnr)n, false, true);
+        } catch (...) {
+            SecureString::wipeMemory(buffer, sizeof(buffer));
+            throw;
+        }
+    }
+    //the buffer held plaintext
+    SecureString::wipeMemory(buffer, sizeof(buffer));
+    return ok;
+}
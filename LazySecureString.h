@@ -0,0 +1,126 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2014 Alexander Nilsson
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef LAZYSECURESTRING_H_INCLUDED
+#define LAZYSECURESTRING_H_INCLUDED
+
+#include "SecureString.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+namespace Caelus {
+    namespace Utilities {
+
+        /**
+         * LazySecureString class, a SecureString that is loaded from a provider the
+         * first time it is used. Nothing is read or allocated for secrets that are
+         * never used. The provider is called exactly once, even if several threads
+         * use the string at the same time. After that the string follows the usual
+         * SecureString rules for thread safety.
+         */
+        class LazySecureString {
+        public:
+            /**
+             * Loads the secret into value.
+             * @param value - an empty string to assign (or append) the secret to
+             * @param context - the context pointer given to the constructor
+             * @return false on failure
+             */
+            typedef bool (*Provider)(SecureString& value, void* context);
+
+        public:
+
+            /**
+             * Constructor:
+             * The secret is loaded by calling provider on first use
+             * @param provider - the function to call
+             * @param context - passed to the provider as is
+             */
+            LazySecureString(Provider provider, void* context = NULL);
+
+            /**
+             * Constructor:
+             * The secret is the contents of the file at path, read on first use.
+             * The contents are taken as is, including any trailing linefeed.
+             * @param path - the file to read
+             */
+            LazySecureString(const std::string& path);
+
+            /**
+             * Constructor:
+             * The secret is read from fd, from its current position until end of
+             * file, on first use. The descriptor is not closed.
+             * @param fd - the file descriptor to read
+             */
+            LazySecureString(int fd);
+
+            /** Destructor **/
+            ~LazySecureString(void);
+
+            /**
+             * This returns the secret, loading it first if this is the first use.
+             * If loading fails the string is empty, see failed(). If the provider
+             * throws, for example std::bad_alloc over the memory budget, the
+             * exception is passed on and the next call tries to load again.
+             * @return the secret
+             */
+            SecureString& get();
+
+            /**
+             * This returns true if the secret has been loaded (or failed to load)
+             * @return true if loaded
+             */
+            bool loaded() const;
+
+            /**
+             * This returns true if loading the secret failed
+             * @return true on failure
+             */
+            bool failed() const;
+
+        private:
+            void load();
+            static bool readFile(SecureString& value, void* context);
+            static bool readDescriptor(SecureString& value, void* context);
+            static bool readAll(SecureString& value, int fd);
+
+            //never copied
+            LazySecureString(const LazySecureString&);
+            LazySecureString& operator= (const LazySecureString&);
+
+        private:
+            Provider _provider;
+            void* _context;
+            std::string _path;
+            int _fd;
+
+            std::once_flag _once;
+            std::atomic<SecureString*> _value;
+            bool _failed;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,58 @@
+#include "MemoryResource.h"
+
+#include <new>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+using namespace Caelus::Utilities;
+
+namespace {
+    /**
+     * Allocates with operator new. Blocks with a larger alignment than operator
+     * new guarantees come from the aligned operator new on C++17, and from the
+     * aligned allocation function of the C library before that, so that they are
+     * not over-allocated by the alignment.
+     */
+    class NewDeleteResource : public MemoryResource {
+    protected:
+        virtual void* doAllocate(size_t bytes, size_t alignment){
+            if (alignment <= DEFAULT_ALIGNMENT)
+                return ::operator new(bytes);
+#if defined(__cpp_aligned_new)
+            return ::operator new(bytes, std::align_val_t(alignment));
+#elif defined(_WIN32)
+            void* block = _aligned_malloc(bytes, alignment);
+            if (block == NULL)
+                throw std::bad_alloc();
+            return block;
+#else
+            void* block;
+            if (posix_memalign(&block, alignment, bytes) != 0)
+                throw std::bad_alloc();
+            return block;
+#endif
+        }
+
+        virtual void doDeallocate(void* block, size_t, size_t alignment){
+            if (alignment <= DEFAULT_ALIGNMENT){
+                ::operator delete(block);
+                return;
+            }
+#if defined(__cpp_aligned_new)
+            ::operator delete(block, std::align_val_t(alignment));
+#elif defined(_WIN32)
+            _aligned_free(block);
+#else
+            free(block);
+#endif
+        }
+    };
+}
+
+MemoryResource* Caelus::Utilities::newDeleteResource(){
+    //never destroyed, strings with static storage duration may outlive it otherwise
+    static MemoryResource* resource = new NewDeleteResource();
+    return resource;
+}
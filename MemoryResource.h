@@ -0,0 +1,132 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2014 Alexander Nilsson
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef MEMORYRESOURCE_H_INCLUDED
+#define MEMORYRESOURCE_H_INCLUDED
+
+#include <cstddef>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define MEMORYRESOURCE_HAS_PMR
+#endif
+#endif
+
+namespace Caelus {
+    namespace Utilities {
+
+        /**
+         * MemoryResource class, the interface SecureString allocates its memory
+         * through. It mirrors std::pmr::memory_resource, which is not available
+         * before C++17, see PmrMemoryResource for using a standard resource.
+         * A resource must outlive every string that allocates from it.
+         */
+        class MemoryResource {
+        public:
+            enum { DEFAULT_ALIGNMENT = alignof(std::max_align_t) };
+
+            virtual ~MemoryResource() {}
+
+            /**
+             * This allocates a block of at least bytes bytes
+             * @param bytes - the size in bytes
+             * @param alignment - the alignment, a power of two
+             * @return the block, never NULL
+             * @throws std::bad_alloc if the memory could not be allocated
+             */
+            void* allocate(size_t bytes, size_t alignment = DEFAULT_ALIGNMENT){
+                return doAllocate(bytes, alignment);
+            }
+
+            /**
+             * This releases a block returned by allocate()
+             * @param block - the block
+             * @param bytes - the size it was allocated with
+             * @param alignment - the alignment it was allocated with
+             */
+            void deallocate(void* block, size_t bytes, size_t alignment = DEFAULT_ALIGNMENT){
+                doDeallocate(block, bytes, alignment);
+            }
+
+            /**
+             * This returns true if memory allocated from other can be released
+             * through this resource and vice versa
+             * @param other - the resource to compare with
+             * @return true - if the resources are interchangeable
+             */
+            bool isEqual(const MemoryResource& other) const{
+                return doIsEqual(other);
+            }
+
+        protected:
+            virtual void* doAllocate(size_t bytes, size_t alignment) = 0;
+            virtual void doDeallocate(void* block, size_t bytes, size_t alignment) = 0;
+            virtual bool doIsEqual(const MemoryResource& other) const{
+                return this == &other;
+            }
+        };
+
+        /**
+         * This returns the resource that allocates with operator new, it is never
+         * destroyed
+         * @return the resource
+         */
+        MemoryResource* newDeleteResource();
+
+#ifdef MEMORYRESOURCE_HAS_PMR
+        /**
+         * PmrMemoryResource class, makes a std::pmr::memory_resource usable as a
+         * MemoryResource, e.g. a std::pmr::monotonic_buffer_resource for short
+         * lived strings. The wrapped resource must outlive the adapter.
+         */
+        class PmrMemoryResource : public MemoryResource {
+        public:
+            explicit PmrMemoryResource(std::pmr::memory_resource* resource) : _resource(resource) {}
+
+            std::pmr::memory_resource* resource() const{
+                return _resource;
+            }
+
+        protected:
+            virtual void* doAllocate(size_t bytes, size_t alignment){
+                return _resource->allocate(bytes, alignment);
+            }
+
+            virtual void doDeallocate(void* block, size_t bytes, size_t alignment){
+                _resource->deallocate(block, bytes, alignment);
+            }
+
+            virtual bool doIsEqual(const MemoryResource& other) const{
+                const PmrMemoryResource* pmr = dynamic_cast<const PmrMemoryResource*>(&other);
+                return pmr != NULL && _resource->is_equal(*pmr->_resource);
+            }
+
+        private:
+            std::pmr::memory_resource* _resource;
+        };
+#endif
+    }
+}
+
+#endif
@@ -0,0 +1,83 @@
+#include "PoolResource.h"
+
+#include <string.h>
+
+using namespace Caelus::Utilities;
+
+PoolResource::PoolResource(MemoryResource* upstream) : _upstream(upstream){
+    for (int i = 0; i < CLASSES; i++){
+        _free[i] = NULL;
+    }
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+PoolResource::~PoolResource(){
+    for (size_t i = 0; i < _chunks.size(); i++){
+        _upstream->deallocate(_chunks[i], CHUNK, CHUNK_ALIGNMENT);
+    }
+}
+
+MemoryResource* PoolResource::upstream() const{
+    return _upstream;
+}
+
+PoolResource::Statistics PoolResource::statistics() const{
+    std::lock_guard<std::mutex> lock(_lock);
+    return _stats;
+}
+
+int PoolResource::sizeClass(size_t bytes, size_t alignment){
+    //blocks are aligned to their size, up to the alignment of the chunks
+    if (alignment > CHUNK_ALIGNMENT)
+        return -1;
+    int c = 0;
+    while (((size_t)1 << (c + MIN_SHIFT)) < bytes){
+        if (++c == CLASSES)
+            return -1;
+    }
+    return c;
+}
+
+void* PoolResource::doAllocate(size_t bytes, size_t alignment){
+    int c = sizeClass(bytes, alignment);
+    if (c < 0){
+        void* block = _upstream->allocate(bytes, alignment);
+        std::lock_guard<std::mutex> lock(_lock);
+        _stats.largeBytes += bytes;
+        return block;
+    }
+
+    size_t blocksize = (size_t)1 << (c + MIN_SHIFT);
+    std::lock_guard<std::mutex> lock(_lock);
+    if (_free[c] == NULL){
+        //carve a new chunk into blocks of this class
+        _chunks.reserve(_chunks.size() + 1);
+        char* chunk = (char*)_upstream->allocate(CHUNK, CHUNK_ALIGNMENT);
+        _chunks.push_back(chunk);
+        _stats.chunkBytes += CHUNK;
+        for (size_t offset = CHUNK; offset >= blocksize; offset -= blocksize){
+            void* block = chunk + offset - blocksize;
+            *(void**)block = _free[c];
+            _free[c] = block;
+        }
+    }
+    void* block = _free[c];
+    _free[c] = *(void**)block;
+    _stats.usedBytes += blocksize;
+    return block;
+}
+
+void PoolResource::doDeallocate(void* block, size_t bytes, size_t alignment){
+    int c = sizeClass(bytes, alignment);
+    if (c < 0){
+        _upstream->deallocate(block, bytes, alignment);
+        std::lock_guard<std::mutex> lock(_lock);
+        _stats.largeBytes -= bytes;
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_lock);
+    *(void**)block = _free[c];
+    _free[c] = block;
+    _stats.usedBytes -= (size_t)1 << (c + MIN_SHIFT);
+}
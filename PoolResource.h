@@ -0,0 +1,110 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2014 Alexander Nilsson
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef POOLRESOURCE_H_INCLUDED
+#define POOLRESOURCE_H_INCLUDED
+
+#include "MemoryResource.h"
+
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+
+namespace Caelus {
+    namespace Utilities {
+
+        /**
+         * PoolResource class, a MemoryResource that recycles blocks. Blocks of up to
+         * 16 KiB are served from power of two size classes (64 bytes and up), which
+         * match the size classes of SecureString storage. Each class has a free list,
+         * so allocating and releasing a block takes constant time. Classes are carved
+         * from 64 KiB chunks taken from an upstream resource, larger blocks are passed
+         * on to the upstream resource as they are.
+         * Blocks are not zeroed when they are released, SecureString wipes its memory
+         * before releasing it. Chunks are only returned upstream when the pool is
+         * destroyed, so the pool must outlive every string that allocates from it.
+         * The pool is thread safe.
+         */
+        class PoolResource : public MemoryResource {
+        public:
+            /** Counters of the memory held by the pool **/
+            struct Statistics {
+                uint64_t chunkBytes; //taken from upstream for the size classes
+                uint64_t usedBytes;  //handed out from the size classes
+                uint64_t largeBytes; //passed through to upstream
+            };
+
+            /**
+             * Constructor:
+             * Creates an empty pool.
+             * @param upstream - the resource chunks and large blocks are allocated from
+             */
+            explicit PoolResource(MemoryResource* upstream = newDeleteResource());
+
+            /**
+             * Destructor, returns all chunks to the upstream resource
+             */
+            ~PoolResource();
+
+            /**
+             * This returns the resource the pool allocates its chunks from
+             * @return the upstream resource
+             */
+            MemoryResource* upstream() const;
+
+            /**
+             * This returns a snapshot of the pool counters
+             * @return the counters
+             */
+            Statistics statistics() const;
+
+        protected:
+            virtual void* doAllocate(size_t bytes, size_t alignment);
+            virtual void doDeallocate(void* block, size_t bytes, size_t alignment);
+
+        private:
+            enum {
+                MIN_SHIFT = 6,           //64 bytes
+                MAX_SHIFT = 14,          //16 KiB
+                CLASSES = MAX_SHIFT - MIN_SHIFT + 1,
+                CHUNK = 64 * 1024,
+                CHUNK_ALIGNMENT = 64
+            };
+
+            static int sizeClass(size_t bytes, size_t alignment);
+
+            //never copied
+            PoolResource(const PoolResource&);
+            PoolResource& operator= (const PoolResource&);
+
+        private:
+            mutable std::mutex _lock;
+            MemoryResource* _upstream;
+            void* _free[CLASSES];
+            std::vector<void*> _chunks;
+            Statistics _stats;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,186 @@
+#include "SecretArena.h"
+
+#ifdef __linux__
+#include <algorithm>
+#include <errno.h>
+#include <new>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef SYS_memfd_secret
+#if defined(__x86_64__) || defined(__aarch64__) || defined(__riscv)
+#define SYS_memfd_secret 447
+#endif
+#endif
+
+using namespace Caelus::Utilities;
+
+SecretArena& SecretArena::instance(){
+    //never destroyed, strings with static storage duration may outlive it otherwise
+    static SecretArena* arena = new SecretArena();
+    return *arena;
+}
+
+SecretArena::SecretArena(){
+    for (int i = 0; i < CLASSES; i++){
+        _free[i] = NULL;
+    }
+#ifdef SYS_memfd_secret
+    _secretAvailable = true;
+#else
+    _secretAvailable = false;
+#endif
+    _lockAvailable = true;
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+void* SecretArena::allocateBlock(size_t size){
+    std::lock_guard<std::mutex> lock(_lock);
+    int c = sizeClass(size);
+    if (c < 0){
+        //too large for the size classes, give it a mapping of its own
+        Backing backing;
+        void* block = map(pageRound(size), &backing);
+        if (block != NULL){
+            _large[block] = backing;
+            _stats.usedBytes += pageRound(size);
+        }
+        return block;
+    }
+
+    size_t blocksize = (size_t)1 << (c + MIN_SHIFT);
+    if (_free[c] == NULL){
+        //carve a new chunk into blocks of this class
+        Backing backing;
+        char* chunk = (char*)map(CHUNK, &backing);
+        if (chunk == NULL)
+            return NULL;
+        for (size_t offset = CHUNK; offset >= blocksize; offset -= blocksize){
+            void* block = chunk + offset - blocksize;
+            *(void**)block = _free[c];
+            _free[c] = block;
+        }
+    }
+    void* block = _free[c];
+    _free[c] = *(void**)block;
+    *(void**)block = NULL;
+    _stats.usedBytes += blocksize;
+    return block;
+}
+
+void SecretArena::releaseBlock(void* block, size_t size){
+    if (block == NULL)
+        return;
+    std::lock_guard<std::mutex> lock(_lock);
+    int c = sizeClass(size);
+    if (c < 0){
+        memset(block, 0, size);
+        unmap(block, pageRound(size));
+        _stats.usedBytes -= pageRound(size);
+        return;
+    }
+    size_t blocksize = (size_t)1 << (c + MIN_SHIFT);
+    memset(block, 0, blocksize);
+    *(void**)block = _free[c];
+    _free[c] = block;
+    _stats.usedBytes -= blocksize;
+}
+
+void* SecretArena::doAllocate(size_t bytes, size_t alignment){
+    //blocks are aligned to their size class and large blocks to the page, so
+    //rounding the size up to the alignment is enough (up to the page size)
+    if (alignment > (size_t)sysconf(_SC_PAGESIZE))
+        throw std::bad_alloc();
+    void* block = allocateBlock(std::max(bytes, alignment));
+    if (block == NULL)
+        throw std::bad_alloc();
+    return block;
+}
+
+void SecretArena::doDeallocate(void* block, size_t bytes, size_t alignment){
+    releaseBlock(block, std::max(bytes, alignment));
+}
+
+SecretArena::Backing SecretArena::backing() const{
+    std::lock_guard<std::mutex> lock(_lock);
+    return _secretAvailable ? SECRET : (_lockAvailable ? LOCKED : UNLOCKED);
+}
+
+SecretArena::Statistics SecretArena::statistics() const{
+    std::lock_guard<std::mutex> lock(_lock);
+    return _stats;
+}
+
+int SecretArena::sizeClass(size_t size){
+    if (size > ((size_t)1 << MAX_SHIFT))
+        return -1;
+    int c = 0;
+    while (((size_t)1 << (c + MIN_SHIFT)) < size){
+        c++;
+    }
+    return c;
+}
+
+size_t SecretArena::pageRound(size_t size){
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return (size + page - 1) / page * page;
+}
+
+void* SecretArena::map(size_t size, Backing* mapped){
+    void* block = MAP_FAILED;
+    Backing backing = UNLOCKED;
+
+#ifdef SYS_memfd_secret
+    if (_secretAvailable){
+        int fd = (int)syscall(SYS_memfd_secret, 0);
+        if (fd < 0){
+            //not supported by this kernel, or disabled (secretmem.enable=0)
+            _secretAvailable = false;
+        }
+        else {
+            //mapping fails with EAGAIN when RLIMIT_MEMLOCK would be exceeded,
+            //the chunk then falls back to anonymous memory
+            if (ftruncate(fd, size) == 0){
+                block = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            close(fd);
+            backing = SECRET;
+        }
+    }
+#endif
+
+    if (block == MAP_FAILED){
+        block = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (block == MAP_FAILED)
+            return NULL;
+        backing = UNLOCKED;
+        if (_lockAvailable){
+            if (mlock(block, size) == 0){
+                backing = LOCKED;
+            }
+            else {
+                //over RLIMIT_MEMLOCK, later chunks will fail the same way
+                _lockAvailable = false;
+            }
+        }
+    }
+#ifdef MADV_DONTDUMP
+    madvise(block, size, MADV_DONTDUMP);
+#endif
+    _stats.mappedBytes[backing] += size;
+    *mapped = backing;
+    return block;
+}
+
+void SecretArena::unmap(void* block, size_t size){
+    //only the dedicated mappings of large blocks are ever unmapped
+    std::map<void*, Backing>::iterator it = _large.find(block);
+    if (it != _large.end()){
+        _stats.mappedBytes[it->second] -= size;
+        _large.erase(it);
+    }
+    munmap(block, size);
+}
+#endif
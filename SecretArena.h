@@ -0,0 +1,127 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2014 Alexander Nilsson
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef SECRETARENA_H_INCLUDED
+#define SECRETARENA_H_INCLUDED
+
+#include "MemoryResource.h"
+
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+
+//memfd_secret and the mapping flags are Linux only, elsewhere the class is left out
+#ifdef __linux__
+namespace Caelus {
+    namespace Utilities {
+
+        /**
+         * SecretArena class, an allocator for secret data on Linux. Memory is taken
+         * from memfd_secret (Linux 5.14+), which removes the pages from the kernel's
+         * direct map and keeps them locked in RAM. Where that is not available the
+         * arena falls back to mlock'ed anonymous memory, and to unlocked anonymous
+         * memory if the RLIMIT_MEMLOCK limit is reached. All mappings are excluded
+         * from core dumps.
+         * Small blocks are served from power of two size classes (16 to 4096 bytes)
+         * carved from shared chunks, with a free list per class. Larger blocks get a
+         * mapping of their own. Blocks are zeroed when they are released.
+         * The arena is a MemoryResource, so strings can allocate from it by passing
+         * it to their constructor or making it the default resource. Blocks are
+         * allocated and released through the MemoryResource interface only, so
+         * they are sized the same way whichever reference they are used through.
+         */
+        class SecretArena : public MemoryResource {
+        public:
+            /** The kind of memory the arena maps **/
+            enum Backing {
+                SECRET,   //memfd_secret
+                LOCKED,   //mlock'ed anonymous memory
+                UNLOCKED  //plain anonymous memory
+            };
+
+            /** Counters of the memory mapped by the arena **/
+            struct Statistics {
+                uint64_t mappedBytes[3]; //indexed by Backing
+                uint64_t usedBytes;      //bytes handed out, rounded up to the size class
+            };
+
+        public:
+
+            /**
+             * This returns the process wide arena, it is never destroyed
+             * @return the arena
+             */
+            static SecretArena& instance();
+
+            /**
+             * This returns the kind of memory new chunks are mapped from
+             * @return the preferred backing that is currently available
+             */
+            Backing backing() const;
+
+            /**
+             * This returns a snapshot of the arena counters
+             * @return the counters
+             */
+            Statistics statistics() const;
+
+        protected:
+            virtual void* doAllocate(size_t bytes, size_t alignment);
+            virtual void doDeallocate(void* block, size_t bytes, size_t alignment);
+
+        private:
+            enum {
+                MIN_SHIFT = 4,           //16 bytes
+                MAX_SHIFT = 12,          //4096 bytes
+                CLASSES = MAX_SHIFT - MIN_SHIFT + 1,
+                CHUNK = 16 * 1024
+            };
+
+            SecretArena();
+            //a block of at least size bytes, NULL if no memory could be mapped
+            void* allocateBlock(size_t size);
+            //zeroes and releases a block, size is the size it was allocated with
+            void releaseBlock(void* block, size_t size);
+            static int sizeClass(size_t size);
+            void* map(size_t size, Backing* mapped);
+            void unmap(void* block, size_t size);
+            static size_t pageRound(size_t size);
+
+            //never copied
+            SecretArena(const SecretArena&);
+            SecretArena& operator= (const SecretArena&);
+
+        private:
+            mutable std::mutex _lock;
+            void* _free[CLASSES];
+            std::map<void*, Backing> _large;
+            bool _secretAvailable;
+            bool _lockAvailable;
+            Statistics _stats;
+        };
+    }
+}
+#endif
+
+#endif
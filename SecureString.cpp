@@ -1,487 +1,1495 @@
-#include "SecureString.h"
-
-#include <string.h>
-#include <algorithm>
-
-////////////////////////////////////////////////////////////////////////////////
-//crc32 from http://web.archive.org/web/20080217222203/http://c.snippets.org/ //
-////////////////////////////////////////////////////////////////////////////////
-#define DWORD uint32_t
-#define BYTE uint8_t
-
-DWORD updateCRC32(unsigned char ch, DWORD crc);
-DWORD crc32buf(const char *buf, size_t len);
-////////////////////////////////////////////////////////////////////////////////
-
-#ifdef SECURESTRING_OVERRIDE_DEFAULT_ALLOCATED
-#define DEFAULT_ALLOCATED SECURESTRING_OVERRIDE_DEFAULT_ALLOCATED
-#else
-#define DEFAULT_ALLOCATED 80
-#endif
-
-using namespace Caelus::Utilities;
-
-SecureString::SecureString(void){
-    init();
-}
-
-SecureString::SecureString(ssnr size){
-    init();
-    allocate(size);
-}
-
-SecureString::SecureString(ssarr str, ssnr maxlen, bool deleteStr, bool allowNull){
-    init();
-    assign(str, maxlen, deleteStr, allowNull);
-}
-
-SecureString::SecureString(c_ssarr str, ssnr maxlen){
-    init();
-    assign(str, maxlen);
-}
-
-SecureString::SecureString(const SecureString& src){
-    init();
-    assign(src);
-}
-
-SecureString::~SecureString(void)
-{
-    //Destroy all unsecured data
-    UnsecuredStringFinished(); //is already thread safe
-
-    __securestring_thread_lock();
-    //Zero out all data
-    memset(_data, 0, allocated());
-    memset(_key, 0, allocated());
-    _length = 0;
-    _allocated = 0;
-
-    //deallocate arrays
-    delete[] _data;
-    delete[] _key;
-}
-
-void SecureString::init(){
-    __securestring_thread_lock();
-    _data = new ssbyte[sizeof(ssnr)];
-    _key = new ssbyte[sizeof(ssnr)];
-    //fill key with zeros, this keeps the length() and allocated() from failing before any call to allocate(x)
-    *((ssnr*)_data) = 0;
-    *((ssnr*)_key) = 0;
-    _length = 0;
-    _allocated = 0;
-    _plaintextcopy = NULL;
-#ifdef SECURESTRING_KEEP_PLAINTEXT_DEBUG_COPY
-    _debug_plaintextcopy = NULL;
-#endif
-    _mutableplaintextcopy = false;
-    resetLinefeedPosition();
-}
-
-void SecureString::allocate(ssnr size){
-    __securestring_thread_lock();
-    allocateImpl(size);
-}
-
-void SecureString::allocateImpl(ssnr size){
-    //increase size by one to include last '\0'
-    size += 1;
-    //the new array must at least be able to hold a key the size of ssnr
-    if (size <= sizeof(ssnr)){
-        size = sizeof(ssnr)+1; //include last '\0'
-    }
-    //check if new size is larger than current string length
-    if (size <= length()){
-        size = length() + 1; //include last '\0'
-    }
-
-    //create the new arrays
-    ssarr newdata = new ssbyte[size];
-    ssarr newkey = new ssbyte[size];
-
-    //store the length of the string
-    ssnr strlen = length();
-
-    //fill the key array with random data
-    //and the data array as a mirror (xor equals zero)
-    for (ssnr i = 0; i < size; i++){
-        newkey[i] = (ssbyte)rand();
-        newdata[i] = newkey[i];
-    }
-
-    //copy existing data over to the new array
-    if (allocated()){
-        ssnr nrOfOldAllocatedBytes = allocated();
-        //After this the old key and data is zeroed out (length() and allocate() will not work)
-        for (ssnr i = 0; i < nrOfOldAllocatedBytes; i++){
-            newdata[i] = newkey[i] ^ (_key[i] ^ _data[i]);
-            //fill old data and key with zeroes
-            _data[i] = 0;
-            _key[i] = 0;
-        }
-    }
-    _length = strlen ^ ((ssnr)*newkey);
-    _allocated = (size - 1) ^ ((ssnr)*newkey);
-
-    //deallocate the old arrays
-    delete[] _data;
-    delete[] _key;
-    _data = newdata;
-    _key = newkey;
-}
-
-void SecureString::append(ssarr str, ssnr maxlen, bool deleteStr, bool allowNull){
-    __securestring_thread_lock();
-    //set len to strlen(str) or maxlen, wichever is lowest (except if maxlen is 0 then set len to strlen(0))
-    //ssnr len = (maxlen == 0) ? strlen(str) : std::min((ssnr)strlen(str), maxlen);
-    ssnr len;
-
-    if (maxlen == 0)
-    {
-        len = strlen(str);
-    }
-    else if (allowNull)
-    {
-        len = maxlen;
-    }
-    else
-    {
-        len = std::min((ssnr)strlen(str), maxlen);
-    }
-
-    ssnr oldlen = length();
-    //calculate the new total length
-    ssnr totlen = oldlen + len;
-    //Check if there is room for the new string
-    if (totlen > allocated()){
-        allocateImpl(totlen * 2); //make more room than neccessary, just in case there will be more appends later
-    }
-    for (ssnr i = 0; i < len; i++){
-        //Store in  array
-        _data[oldlen + i] = _key[oldlen + i] ^ str[i];
-        //recalculate checksum
-        if (oldlen == 0 && i == 0)
-            _checksum = crc32buf(&(str[i]), 1);
-        else
-            _checksum = updateCRC32(str[i], _checksum);
-    }
-    _length = ((ssnr)*_key) ^ totlen;
-    if (deleteStr){
-        memset(str, 0, len);
-        delete[] str;
-    }
-    resetLinefeedPosition();
-
-#ifdef SECURESTRING_KEEP_PLAINTEXT_DEBUG_COPY
-    _store_debug_plaintextcopy();
-#endif
-}
-
-void SecureString::append(c_ssarr str, ssnr maxlen){
-    append((ssarr)str, maxlen, false);
-}
-
-void SecureString::append(const SecureString& str){
-    __securestring_thread_lock();
-    ssnr len = str.length();
-    ssnr oldlen = this->length();
-    ssnr totlen = oldlen + len;
-    if (totlen > this->allocated()){
-        this->allocateImpl(totlen * 2); //make more room than neccessary, just in case there will be more appends later
-    }
-    for (ssnr i = 0; i < len; i++){
-        ssbyte c = str._data[i] ^ str._key[i];
-        //Store in array
-        this->_data[i + oldlen] = this->_key[oldlen + i] ^ c;
-        //recalculate checksum
-        if (oldlen == 0 && i == 0)
-            _checksum = crc32buf(&c, 1);
-        else
-            _checksum = updateCRC32(c, _checksum);
-    }
-    _length = ((ssnr)*_key) ^ totlen;
-    resetLinefeedPosition();
-
-#ifdef SECURESTRING_KEEP_PLAINTEXT_DEBUG_COPY
-    _store_debug_plaintextcopy();
-#endif
-}
-
-void SecureString::assign(ssarr str, ssnr maxlen, bool deleteStr, bool allowNull){
-    __securestring_thread_lock();
-    //set len to strlen(str) or maxlen, wichever is lowest (except if maxlen is 0 then set len to strlen(0))
-    //ssnr len = (maxlen == 0) ? strlen(str) : std::min((ssnr)strlen(str), maxlen);
-    ssnr len;
-
-    if (maxlen == 0)
-    {
-        len = strlen(str);
-    }
-    else if (allowNull)
-    {
-        len = maxlen;
-    }
-    else
-    {
-        len = std::min((ssnr)strlen(str), maxlen);
-    }
-
-    //remove old data
-    if (length() > 0){
-        ssnr oldlen = length();
-        memcpy(_data, _key, oldlen);
-    }
-
-    //allocate enough space
-    if (len > allocated()){
-        allocateImpl(len * 2); //make more room than neccessary, just in case there will be more appends later
-    }
-    for (ssnr i = 0; i < len; i++){
-        _data[i] = _key[i] ^ str[i];
-    }
-    _data[len] = _key[len];
-    _length = ((ssnr)*_key) ^ len;
-
-    //caclulate checksum
-    _checksum = crc32buf(str, len);
-
-    if (deleteStr){
-        memset(str, 0, len);
-        delete[] str;
-    }
-    resetLinefeedPosition();
-
-#ifdef SECURESTRING_KEEP_PLAINTEXT_DEBUG_COPY
-    _store_debug_plaintextcopy();
-#endif
-}
-
-void SecureString::assign(c_ssarr str, ssnr maxlen){
-    assign((ssarr)str, maxlen, false);
-}
-
-void SecureString::assign(const SecureString& str){
-    __securestring_thread_lock();
-    //remove old data
-    if (length() > 0){
-        ssnr oldlen = length();
-        memcpy(_data, _key, oldlen);
-    }
-
-    ssnr len = str.length();
-    if (len > this->allocated()){
-        this->allocateImpl(len * 2); //make more room than neccessary, just in case there will be more appends later
-    }
-    for (ssnr i = 0; i < len; i++){
-        this->_data[i] = this->_key[i] ^ (str._key[i] ^ str._data[i]);
-    }
-    _length = ((ssnr)*_key) ^ len;
-
-    //checksum is already calculated by other instance, no need to do it again
-    _checksum = str._checksum;
-
-    resetLinefeedPosition();
-
-#ifdef SECURESTRING_KEEP_PLAINTEXT_DEBUG_COPY
-    _store_debug_plaintextcopy();
-#endif
-}
-
-SecureString::c_ssarr SecureString::getUnsecureString(){
-    __securestring_thread_lock();
-    return getUnsecureStringImpl();
-}
-SecureString::c_ssarr SecureString::getUnsecureStringImpl(){
-    //there can only be one unsecure plaintext copy at a time
-    if (_plaintextcopy != NULL)
-        return NULL;
-    ssnr size = length();
-    _plaintextcopy = new ssbyte[size + 1];
-    _plaintextcopy[size] = '\0';
-    for (ssnr i = 0; i < size; i++){
-        _plaintextcopy[i] = _key[i] ^ _data[i];
-    }
-    _mutableplaintextcopy = false;
-    return _plaintextcopy;
-}
-
-SecureString::ssarr SecureString::getUnsecureStringM(){
-    __securestring_thread_lock();
-    ssarr ret = (ssarr)getUnsecureStringImpl();
-    _mutableplaintextcopy = true;
-    return ret;
-}
-
-SecureString::c_ssarr SecureString::getUnsecureNextline(){
-    __securestring_thread_lock();
-    //there can only be one unsecure plaintext copy at a time
-    if (_plaintextcopy != NULL)
-        return NULL;
-
-    int startPos = (((ssnr)*_key) ^ _nexlinefeedposition);
-    int tLen = ((ssnr)*_key) ^ _length;
-    int sLen = 0;
-    int CRLF = 0;
-
-    //Find next linefeed
-    for (int i = startPos; i < tLen; i++){
-        if (at(i) == '\n'){
-            sLen = i - startPos;
-            break;
-        }
-        else if (at(i) == '\r'){
-            sLen = i - startPos;
-            if (at(i + 1) == '\n'){
-                CRLF = 1;
-            }
-            break;
-        }
-    }
-
-    //create new buffert
-    ssarr line = new ssbyte[sLen + 1];
-
-    //copy text over to the unsecured buffer
-    for (int i = 0; i < sLen; i++){
-        line[i] = _key[startPos + i] ^ _data[startPos + i];
-    }
-    line[sLen] = '\0';
-
-    _nexlinefeedposition = ((ssnr)*_key) ^ (startPos + sLen + 1 + CRLF);
-
-    //line is the plaintextcopy
-    _plaintextcopy = line;
-    _mutableplaintextcopy = false;
-    return _plaintextcopy;
-}
-
-void SecureString::UnsecuredStringFinished(){
-    __securestring_thread_lock();
-    if (_plaintextcopy == NULL)
-        return;
-    if (_mutableplaintextcopy){
-        assign(_plaintextcopy, 0, true);
-    }
-    else {
-        memset(_plaintextcopy, 0, strlen(_plaintextcopy));
-        delete[] _plaintextcopy;
-    }
-    _plaintextcopy = NULL;
-}
-
-bool SecureString::equals(const SecureString& s2) const{
-    __securestring_thread_lock();
-    if (s2.length() != this->length()){
-        return false;
-    }
-    return _checksum == s2._checksum;
-}
-
-bool SecureString::equals(const char* s2) const{
-    __securestring_thread_lock();
-    unsigned int len = this->length();
-    if (strlen(s2) != len){
-        return false;
-    }
-    ssnr s2_checksum = crc32buf(s2, len);
-    return _checksum == s2_checksum;
-}
-
-
-#ifdef SECURESTRING_KEEP_PLAINTEXT_DEBUG_COPY
-void SecureString::_store_debug_plaintextcopy()
-{
-    delete[] _debug_plaintextcopy;
-    ssnr size = length();
-    _debug_plaintextcopy = new ssbyte[size + 1];
-    _debug_plaintextcopy[size] = '\0';
-    for (ssnr i = 0; i < size; i++){
-        _debug_plaintextcopy[i] = _key[i] ^ _data[i];
-    }
-    
-}
-#endif
-
-////////////////////////////////////////////////////////////////////////////////
-//crc32 from http://web.archive.org/web/20080217222203/http://c.snippets.org/ //
-////////////////////////////////////////////////////////////////////////////////
-/* Crc - 32 BIT ANSI X3.66 CRC checksum files */
-
-/* Copyright (C) 1986 Gary S. Brown.  You may use this program, or
-   code or tables extracted from it, as desired without restriction.*/
-
-#include <stdio.h>
-
-/* Need an unsigned type capable of holding 32 bits; */
-
-typedef DWORD UNS_32_BITS;
-
-#define UPDC32(octet,crc) (crc_32_tab[((crc)\
-    ^ ((BYTE)octet)) & 0xff] ^ ((crc) >> 8))
-
-static UNS_32_BITS crc_32_tab[] = { /* CRC polynomial 0xedb88320 */
-    0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
-    0xe963a535, 0x9e6495a3, 0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
-    0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91, 0x1db71064, 0x6ab020f2,
-    0xf3b97148, 0x84be41de, 0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
-    0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec, 0x14015c4f, 0x63066cd9,
-    0xfa0f3d63, 0x8d080df5, 0x3b6e20c8, 0x4c69105e, 0xd56041e4, 0xa2677172,
-    0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b, 0x35b5a8fa, 0x42b2986c,
-    0xdbbbc9d6, 0xacbcf940, 0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59,
-    0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423,
-    0xcfba9599, 0xb8bda50f, 0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924,
-    0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d, 0x76dc4190, 0x01db7106,
-    0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433,
-    0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818, 0x7f6a0dbb, 0x086d3d2d,
-    0x91646c97, 0xe6635c01, 0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e,
-    0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457, 0x65b0d9c6, 0x12b7e950,
-    0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65,
-    0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2, 0x4adfa541, 0x3dd895d7,
-    0xa4d1c46d, 0xd3d6f4fb, 0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0,
-    0x44042d73, 0x33031de5, 0xaa0a4c5f, 0xdd0d7cc9, 0x5005713c, 0x270241aa,
-    0xbe0b1010, 0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
-    0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17, 0x2eb40d81,
-    0xb7bd5c3b, 0xc0ba6cad, 0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a,
-    0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683, 0xe3630b12, 0x94643b84,
-    0x0d6d6a3e, 0x7a6a5aa8, 0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1,
-    0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb,
-    0x196c3671, 0x6e6b06e7, 0xfed41b76, 0x89d32be0, 0x10da7a5a, 0x67dd4acc,
-    0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5, 0xd6d6a3e8, 0xa1d1937e,
-    0x38d8c2c4, 0x4fdff252, 0xd1bb67f1, 0xa6bc5767, 0x3fb506dd, 0x48b2364b,
-    0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55,
-    0x316e8eef, 0x4669be79, 0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236,
-    0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f, 0xc5ba3bbe, 0xb2bd0b28,
-    0x2bb45a92, 0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d,
-    0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a, 0x9c0906a9, 0xeb0e363f,
-    0x72076785, 0x05005713, 0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38,
-    0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21, 0x86d3d2d4, 0xf1d4e242,
-    0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777,
-    0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c, 0x8f659eff, 0xf862ae69,
-    0x616bffd3, 0x166ccf45, 0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2,
-    0xa7672661, 0xd06016f7, 0x4969474d, 0x3e6e77db, 0xaed16a4a, 0xd9d65adc,
-    0x40df0b66, 0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
-    0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd70693,
-    0x54de5729, 0x23d967bf, 0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94,
-    0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
-};
-
-DWORD updateCRC32(unsigned char ch, DWORD crc)
-{
-    return ~UPDC32(ch, ~crc);
-}
-
-DWORD crc32buf(const char *buf, size_t len)
-{
-    register DWORD oldcrc32;
-
-    oldcrc32 = 0xFFFFFFFF;
-
-    for (; len; --len, ++buf)
-    {
-        oldcrc32 = UPDC32(*buf, oldcrc32);
-    }
-
-    return ~oldcrc32;
-
-}
+#include "SecureString.h"
+#include "MemoryResource.h"
+#include "TimerWheel.h"
+#ifdef SECURESTRING_SECRET_STORAGE
+#include "SecretArena.h"
+#endif
+
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#if defined(__AES__) && !defined(SECURESTRING_NO_AESNI)
+#define SECURESTRING_AESNI
+#include <immintrin.h>
+#include <random>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//crc32 from http://web.archive.org/web/20080217222203/http://c.snippets.org/ //
+////////////////////////////////////////////////////////////////////////////////
+#define DWORD uint32_t
+#define BYTE uint8_t
+
+DWORD updateCRC32(unsigned char ch, DWORD crc);
+DWORD crc32buf(const char *buf, size_t len);
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef SECURESTRING_OVERRIDE_DEFAULT_ALLOCATED
+#define DEFAULT_ALLOCATED SECURESTRING_OVERRIDE_DEFAULT_ALLOCATED
+#else
+#define DEFAULT_ALLOCATED 80
+#endif
+
+//key and data arrays are allocated on cache line boundaries in size classes:
+//powers of two from STORAGE_ALIGNMENT up to STORAGE_LARGE, and multiples of
+//STORAGE_LARGE above that. The padding behind the string holds key material
+//like the rest, so neither the block size nor its contents give the length away
+#define STORAGE_ALIGNMENT 64
+#define STORAGE_LARGE (64 * 1024)
+
+using namespace Caelus::Utilities;
+
+/**
+ * The header in front of every plaintext copy, it is allocated in one block with
+ * the copy so that a SecureString only needs a single pointer for it. It is also
+ * the node that is scheduled in the PlaintextReaper when the copy has a deadline,
+ * once that has expired the copy has been wiped.
+ */
+struct Caelus::Utilities::PlaintextCopy : TimerWheel::Node {
+    size_t size;      //of the copy, including the last '\0'
+    bool mutableCopy; //handed out by getUnsecureStringM()
+    bool deadline;    //scheduled in the PlaintextReaper
+    bool expired;     //wiped by the PlaintextReaper
+
+    SecureString::ssarr bytes(){
+        return (SecureString::ssarr)(this + 1);
+    }
+};
+
+namespace {
+    //the contents of a consumed container have been zeroed while they were
+    //read, growing it to its capacity zeroes the unused storage behind them
+    //(e.g. left by an earlier longer value), the buffer itself is kept
+    template <class Container>
+    void wipeContainer(Container& container){
+        container.resize(container.capacity());
+        container.clear();
+    }
+
+    //process wide counters, see SecureString::statistics()
+    std::atomic<uint64_t> allocationCounter(0);
+    std::atomic<uint64_t> deallocationCounter(0);
+    std::atomic<uint64_t> objectCounter(0);
+    std::atomic<uint64_t> liveBytes[4];
+    std::atomic<uint64_t> expiredPlaintextCounter(0);
+    std::atomic<uint64_t> scrubbedCounter(0);
+    std::atomic<uint64_t> corruptedCounter(0);
+
+    //process wide default deadline for plaintext copies, in milliseconds
+    std::atomic<unsigned int> plaintextTimeout(0);
+
+    //see SecureString::setDefaultMemoryResource(), NULL selects the built-in one
+    std::atomic<MemoryResource*> defaultResource(NULL);
+
+    //zeroes memory in a way that is async-signal-safe and never optimized away,
+    //also when the memory goes out of scope or is released right after
+    void volatileZero(void* bytes, size_t size){
+        volatile char* p = (volatile char*)bytes;
+        for (size_t i = 0; i < size; i++){
+            p[i] = 0;
+        }
+    }
+
+    /**
+     * A single background thread that wipes plaintext copies whose deadline has
+     * passed. The deadlines are kept in a TimerWheel with RESOLUTION ms ticks, the
+     * thread only wakes up while there are deadlines pending.
+     * The reaper never locks the strings themselves, it only wipes the copy and
+     * marks the deadline as expired under its own lock, the string frees the copy
+     * as usual in UnsecuredStringFinished().
+     */
+    class PlaintextReaper {
+    public:
+        enum { RESOLUTION = 10 };
+
+        static PlaintextReaper& instance(){
+            //never destroyed, strings with static storage duration may outlive it otherwise
+            static PlaintextReaper* reaper = new PlaintextReaper();
+            return *reaper;
+        }
+
+        void schedule(PlaintextCopy* deadline, unsigned int timeout){
+            std::lock_guard<std::mutex> lock(_lock);
+            if (!_started){
+                std::thread(&PlaintextReaper::run, this).detach();
+                _started = true;
+            }
+            _wheel.schedule(deadline, currentTick() + (timeout + RESOLUTION - 1) / RESOLUTION);
+            _wakeup.notify_one();
+        }
+
+        bool cancel(PlaintextCopy* deadline){
+            std::lock_guard<std::mutex> lock(_lock);
+            _wheel.cancel(deadline);
+            return deadline->expired;
+        }
+
+    private:
+        PlaintextReaper() : _wheel(currentTick()), _started(false) {}
+
+        static uint64_t currentTick(){
+            using namespace std::chrono;
+            return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count() / RESOLUTION;
+        }
+
+        static void onExpire(TimerWheel::Node* node, void*){
+            PlaintextCopy* deadline = static_cast<PlaintextCopy*>(node);
+            memset(deadline->bytes(), 0, deadline->size);
+            deadline->expired = true;
+            expiredPlaintextCounter.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void run(){
+            std::unique_lock<std::mutex> lock(_lock);
+            for (;;){
+                while (_wheel.size() == 0){
+                    _wakeup.wait(lock);
+                }
+                _wakeup.wait_for(lock, std::chrono::milliseconds(RESOLUTION));
+                _wheel.advance(currentTick(), onExpire, NULL);
+            }
+        }
+
+        std::mutex _lock;
+        std::condition_variable _wakeup;
+        TimerWheel _wheel;
+        bool _started;
+    };
+
+    //global storage budget, see SecureString::setMemoryBudget()
+    std::atomic<uint64_t> storageBudget(0);
+    std::mutex pressureCallbacksLock;
+    thread_local bool inPressureCallback = false;
+
+    //marks the thread as inside the pressure callbacks, also when one of them throws
+    struct PressureCallbackScope {
+        PressureCallbackScope(){ inPressureCallback = true; }
+        ~PressureCallbackScope(){ inPressureCallback = false; }
+    };
+
+    typedef std::vector<std::pair<SecureString::MemoryPressureCallback, void*> > PressureCallbacks;
+    PressureCallbacks& pressureCallbacks(){
+        //constructed on first use, strings may be created during static initialization
+        static PressureCallbacks callbacks;
+        return callbacks;
+    }
+
+    /**
+     * Generates key material in blocks of BLOCK bytes. With AES-NI this is
+     * AES-128 in counter mode under a per-thread random key (four blocks in
+     * flight, or a single 512 bit VAES operation where available), otherwise
+     * it falls back to rand().
+     */
+    class KeyStream {
+    public:
+        enum { BLOCK = 64 };
+
+#ifdef SECURESTRING_AESNI
+        KeyStream(){
+            std::random_device rd;
+            uint32_t seed[6];
+            for (int i = 0; i < 6; i++){
+                seed[i] = rd();
+            }
+            expandKey(_mm_loadu_si128((const __m128i*)seed));
+            _nonce = ((uint64_t)seed[4] << 32) | seed[5];
+            _counter = 0;
+            volatileZero(seed, sizeof(seed));
+        }
+
+        ~KeyStream(){
+            volatileZero(_roundkey, sizeof(_roundkey));
+#if defined(__VAES__) && defined(__AVX512F__)
+            volatileZero(_roundkey4, sizeof(_roundkey4));
+#endif
+        }
+
+        void generate(uint8_t* out){
+#if defined(__VAES__) && defined(__AVX512F__)
+            __m512i b = _mm512_set_epi64((long long)_nonce, (long long)(_counter + 3),
+                                         (long long)_nonce, (long long)(_counter + 2),
+                                         (long long)_nonce, (long long)(_counter + 1),
+                                         (long long)_nonce, (long long)_counter);
+            b = _mm512_xor_si512(b, _roundkey4[0]);
+            for (int r = 1; r < 10; r++){
+                b = _mm512_aesenc_epi128(b, _roundkey4[r]);
+            }
+            b = _mm512_aesenclast_epi128(b, _roundkey4[10]);
+            _mm512_storeu_si512((void*)out, b);
+#else
+            __m128i b[4];
+            for (int i = 0; i < 4; i++){
+                b[i] = _mm_xor_si128(_mm_set_epi64x((long long)_nonce, (long long)(_counter + i)), _roundkey[0]);
+            }
+            for (int r = 1; r < 10; r++){
+                for (int i = 0; i < 4; i++){
+                    b[i] = _mm_aesenc_si128(b[i], _roundkey[r]);
+                }
+            }
+            for (int i = 0; i < 4; i++){
+                _mm_storeu_si128((__m128i*)(out + 16 * i), _mm_aesenclast_si128(b[i], _roundkey[10]));
+            }
+#endif
+            _counter += 4;
+        }
+
+    private:
+        static __m128i expandStep(__m128i key, __m128i gen){
+            gen = _mm_shuffle_epi32(gen, 0xff);
+            key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+            key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+            key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+            return _mm_xor_si128(key, gen);
+        }
+
+        void expandKey(__m128i key){
+#define SECURESTRING_EXPAND(i, rcon) \
+            _roundkey[i] = expandStep(_roundkey[i - 1], _mm_aeskeygenassist_si128(_roundkey[i - 1], rcon))
+            _roundkey[0] = key;
+            SECURESTRING_EXPAND(1, 0x01);
+            SECURESTRING_EXPAND(2, 0x02);
+            SECURESTRING_EXPAND(3, 0x04);
+            SECURESTRING_EXPAND(4, 0x08);
+            SECURESTRING_EXPAND(5, 0x10);
+            SECURESTRING_EXPAND(6, 0x20);
+            SECURESTRING_EXPAND(7, 0x40);
+            SECURESTRING_EXPAND(8, 0x80);
+            SECURESTRING_EXPAND(9, 0x1b);
+            SECURESTRING_EXPAND(10, 0x36);
+#undef SECURESTRING_EXPAND
+#if defined(__VAES__) && defined(__AVX512F__)
+            for (int i = 0; i < 11; i++){
+                _roundkey4[i] = _mm512_broadcast_i32x4(_roundkey[i]);
+            }
+#endif
+        }
+
+        __m128i _roundkey[11];
+#if defined(__VAES__) && defined(__AVX512F__)
+        __m512i _roundkey4[11];
+#endif
+        uint64_t _nonce;
+        uint64_t _counter;
+#else
+        void generate(uint8_t* out){
+            for (int i = 0; i < BLOCK; i++){
+                out[i] = (uint8_t)rand();
+            }
+        }
+#endif
+    };
+
+    static_assert(STORAGE_ALIGNMENT % KeyStream::BLOCK == 0, "storage must hold whole key blocks");
+
+    KeyStream& threadKeyStream(){
+        static thread_local KeyStream keystream;
+        return keystream;
+    }
+}
+
+#ifdef SECURESTRING_THREADSAFE
+namespace {
+    /**
+     * Holds the locks of two strings, taken in the order of their addresses so
+     * that two threads copying between the same strings in opposite directions
+     * (or, with striped locks, between strings that share stripes) can not
+     * deadlock. The locks are recursive, so both may be the same lock.
+     */
+    class PairLock {
+    public:
+        PairLock(__securestring_lock_type& a, __securestring_lock_type& b) :
+            _first(std::less<__securestring_lock_type*>()(&a, &b) ? a : b),
+            _second(std::less<__securestring_lock_type*>()(&a, &b) ? b : a){
+            _first.lock();
+            _second.lock();
+        }
+
+        ~PairLock(){
+            _second.unlock();
+            _first.unlock();
+        }
+
+    private:
+        __securestring_lock_type& _first;
+        __securestring_lock_type& _second;
+    };
+}
+# define __securestring_thread_lock_pair(other) PairLock lock(objectLock(), (other).objectLock())
+#else
+# define __securestring_thread_lock_pair(other)
+#endif
+
+#ifdef SECURESTRING_STRIPED_LOCKS
+static_assert((SECURESTRING_LOCK_STRIPES & (SECURESTRING_LOCK_STRIPES - 1)) == 0, "SECURESTRING_LOCK_STRIPES must be a power of two");
+
+namespace {
+    //each lock gets a cache line of its own, so that threads working on strings
+    //in different stripes do not contend on the line
+    struct alignas(STORAGE_ALIGNMENT) LockStripe {
+        __securestring_lock_type lock;
+    };
+
+    LockStripe* createLockStripes(){
+        void* table = newDeleteResource()->allocate(sizeof(LockStripe) * SECURESTRING_LOCK_STRIPES, alignof(LockStripe));
+        LockStripe* stripes = (LockStripe*)table;
+        for (size_t i = 0; i < SECURESTRING_LOCK_STRIPES; i++){
+            new (stripes + i) LockStripe();
+        }
+        return stripes;
+    }
+}
+
+__securestring_lock_type& SecureString::lockStripe(const SecureString* str){
+    //never destroyed, strings with static storage duration may still lock it
+    //while the process exits
+    static LockStripe* stripes = createLockStripes();
+    //strings are at least a cache line apart, the higher bits are folded in so
+    //that strings allocated with a larger stride still spread over the table
+    size_t h = (size_t)(uintptr_t)str / STORAGE_ALIGNMENT;
+    h ^= h / SECURESTRING_LOCK_STRIPES;
+    return stripes[h & (SECURESTRING_LOCK_STRIPES - 1)].lock;
+}
+#endif
+
+#ifdef SECURESTRING_REGISTRY
+/**
+ * A list of the live SecureStrings created by one thread. Every thread gets a
+ * shard of its own, so registering never contends with other threads, the lock
+ * is only shared when a string is destroyed by another thread than the one that
+ * created it. Shards are never freed, they are handed to new threads when their
+ * thread exits.
+ */
+struct Caelus::Utilities::RegistryShard {
+    std::atomic<bool> locked;
+    std::atomic<bool> owned;
+    SecureString* head;
+    RegistryShard* next;
+#ifdef SECURESTRING_SCRUBBER
+    //the next string to be verified by the scrubber
+    SecureString* cursor;
+#endif
+
+    void lock(){
+        while (locked.exchange(true, std::memory_order_acquire)){
+            std::this_thread::yield();
+        }
+    }
+
+    void unlock(){
+        locked.store(false, std::memory_order_release);
+    }
+};
+
+namespace {
+    //all shards ever created, only ever pushed to
+    std::atomic<RegistryShard*> registryShards(NULL);
+
+    //gives the shard back when the thread exits
+    struct ShardOwner {
+        ShardOwner() : shard(NULL) {}
+        ~ShardOwner(){
+            if (shard != NULL)
+                shard->owned.store(false, std::memory_order_release);
+        }
+        RegistryShard* shard;
+    };
+
+    RegistryShard* threadShard(){
+        static thread_local ShardOwner owner;
+        if (owner.shard != NULL)
+            return owner.shard;
+
+        //reuse the shard of a thread that has exited
+        for (RegistryShard* shard = registryShards.load(std::memory_order_acquire); shard != NULL; shard = shard->next){
+            bool owned = false;
+            if (shard->owned.compare_exchange_strong(owned, true, std::memory_order_acquire)){
+                owner.shard = shard;
+                return shard;
+            }
+        }
+
+        RegistryShard* shard = new RegistryShard();
+        shard->locked.store(false);
+        shard->owned.store(true);
+        shard->head = NULL;
+#ifdef SECURESTRING_SCRUBBER
+        shard->cursor = NULL;
+#endif
+        shard->next = registryShards.load(std::memory_order_relaxed);
+        while (!registryShards.compare_exchange_weak(shard->next, shard, std::memory_order_release)){
+        }
+        owner.shard = shard;
+        return shard;
+    }
+}
+
+//called at the end of every constructor, so that wipeAll() and the scrubber
+//never see a string that is only partly constructed
+void SecureString::registerInstance(){
+    RegistryShard* shard = threadShard();
+    shard->lock();
+    _registryShard = shard;
+    _registryPrev = NULL;
+    _registryNext = shard->head;
+    if (shard->head != NULL)
+        shard->head->_registryPrev = this;
+    shard->head = this;
+    shard->unlock();
+}
+
+void SecureString::unregisterInstance(){
+    RegistryShard* shard = _registryShard;
+    shard->lock();
+#ifdef SECURESTRING_SCRUBBER
+    if (shard->cursor == this)
+        shard->cursor = _registryNext;
+#endif
+    if (_registryPrev != NULL)
+        _registryPrev->_registryNext = _registryNext;
+    else
+        shard->head = _registryNext;
+    if (_registryNext != NULL)
+        _registryNext->_registryPrev = _registryPrev;
+    shard->unlock();
+}
+
+size_t SecureString::wipeAll(){
+    size_t count = 0;
+    for (RegistryShard* shard = registryShards.load(std::memory_order_acquire); shard != NULL; shard = shard->next){
+        //the lock may be held by the very thread this signal interrupted, so
+        //only spin for a while and then go ahead regardless
+        bool locked = false;
+        for (int i = 0; i < (1 << 16) && !locked; i++){
+            locked = !shard->locked.exchange(true, std::memory_order_acquire);
+        }
+        for (SecureString* str = shard->head; str != NULL; str = str->_registryNext){
+            str->wipeImpl();
+            count++;
+        }
+        if (locked)
+            shard->unlock();
+    }
+    return count;
+}
+
+void SecureString::wipeImpl(){
+    //this runs in signal handlers, so it takes no locks and calls no library
+    //functions, the fields are read directly
+    volatileZero(_data, _storagesize);
+    volatileZero(_key, _storagesize);
+    if (_plaintextcopy != NULL)
+        volatileZero(_plaintextcopy->bytes(), _plaintextcopy->size);
+#ifdef SECURESTRING_KEEP_PLAINTEXT_DEBUG_COPY
+    if (_debug_plaintextcopy != NULL)
+        volatileZero(_debug_plaintextcopy, _debug_plaintextsize);
+#endif
+    //the key is now all zeroes, so the plain values are stored as is. The
+    //capacity is dropped, so that the next write allocates new arrays under a
+    //fresh key instead of storing plaintext under the zeroed one
+    _length = 0;
+    _allocated = 0;
+    _nexlinefeedposition = 0;
+    _checksum = 0;
+}
+#endif
+
+#ifdef SECURESTRING_SCRUBBER
+namespace {
+    //the progress of the current scrubber pass, shards are never freed
+    std::mutex scrubLock;
+    RegistryShard* scrubShard = NULL;
+    bool scrubShardStarted = false;
+
+    /**
+     * The background thread of the integrity scrubber, it runs one
+     * SecureString::scrub() slice every interval.
+     */
+    class Scrubber {
+    public:
+        static Scrubber& instance(){
+            //never destroyed, strings with static storage duration may outlive it otherwise
+            static Scrubber* scrubber = new Scrubber();
+            return *scrubber;
+        }
+
+        void start(unsigned int interval, unsigned int budget, SecureString::CorruptionCallback callback, void* context){
+            std::lock_guard<std::mutex> lock(_lock);
+            _interval = interval;
+            _budget = budget;
+            _callback = callback;
+            _context = context;
+            if (!_thread.joinable()){
+                _stop = false;
+                _thread = std::thread(&Scrubber::run, this);
+            }
+            _wakeup.notify_one();
+        }
+
+        void stop(){
+            std::thread thread;
+            {
+                std::lock_guard<std::mutex> lock(_lock);
+                _stop = true;
+                thread.swap(_thread);
+                _wakeup.notify_one();
+            }
+            if (thread.joinable())
+                thread.join();
+        }
+
+    private:
+        Scrubber() : _interval(0), _budget(0), _callback(NULL), _context(NULL), _stop(false) {}
+
+        void run(){
+            std::unique_lock<std::mutex> lock(_lock);
+            while (!_stop){
+                _wakeup.wait_for(lock, std::chrono::milliseconds(_interval));
+                if (_stop)
+                    break;
+                unsigned int budget = _budget;
+                SecureString::CorruptionCallback callback = _callback;
+                void* context = _context;
+                lock.unlock();
+                SecureString::scrub(budget, callback, context);
+                lock.lock();
+            }
+        }
+
+        std::mutex _lock;
+        std::condition_variable _wakeup;
+        std::thread _thread;
+        unsigned int _interval;
+        unsigned int _budget;
+        SecureString::CorruptionCallback _callback;
+        void* _context;
+        bool _stop;
+    };
+}
+
+void SecureString::startScrubber(unsigned int interval, unsigned int budget, CorruptionCallback callback, void* context){
+    Scrubber::instance().start(interval, budget, callback, context);
+}
+
+void SecureString::stopScrubber(){
+    Scrubber::instance().stop();
+}
+
+size_t SecureString::scrub(unsigned int budget, CorruptionCallback callback, void* context){
+    //number of strings verified before the shard lock is released again
+    const int BATCH = 16;
+
+    std::lock_guard<std::mutex> guard(scrubLock);
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(budget);
+    size_t count = 0;
+    do {
+        if (scrubShard == NULL){
+            scrubShard = registryShards.load(std::memory_order_acquire);
+            scrubShardStarted = false;
+            if (scrubShard == NULL)
+                break;
+        }
+        RegistryShard* shard = scrubShard;
+        shard->lock();
+        if (!scrubShardStarted){
+            shard->cursor = shard->head;
+            scrubShardStarted = true;
+        }
+        for (int i = 0; i < BATCH && shard->cursor != NULL; i++){
+            SecureString* str = shard->cursor;
+            shard->cursor = str->_registryNext;
+            //a string that is in use is left for the next pass
+            if (!str->objectLock().try_lock())
+                continue;
+            bool valid = str->verify();
+            scrubbedCounter.fetch_add(1, std::memory_order_relaxed);
+            if (!valid){
+                corruptedCounter.fetch_add(1, std::memory_order_relaxed);
+                if (callback != NULL)
+                    callback(*str, context);
+            }
+            str->objectLock().unlock();
+            count++;
+        }
+        bool finished = shard->cursor == NULL;
+        shard->unlock();
+        if (finished){
+            scrubShard = shard->next;
+            scrubShardStarted = false;
+            //a pass over all shards is complete, continue in the next slice
+            if (scrubShard == NULL)
+                break;
+        }
+    } while (std::chrono::steady_clock::now() < deadline);
+    return count;
+}
+#endif
+
+SecureString::SecureString(void){
+    init();
+#ifdef SECURESTRING_REGISTRY
+    registerInstance();
+#endif
+}
+
+SecureString::SecureString(ssnr size){
+    init(size);
+#ifdef SECURESTRING_REGISTRY
+    registerInstance();
+#endif
+}
+
+SecureString::SecureString(MemoryResource& resource){
+    init(&resource);
+#ifdef SECURESTRING_REGISTRY
+    registerInstance();
+#endif
+}
+
+SecureString::SecureString(ssnr size, MemoryResource& resource){
+    init(size, &resource);
+#ifdef SECURESTRING_REGISTRY
+    registerInstance();
+#endif
+}
+
+SecureString::SecureString(ssarr str, ssnr maxlen, bool deleteStr, bool allowNull){
+    ssnr len = inputLength(str, maxlen, allowNull);
+    init(len * 2); //make more room than neccessary, just in case there will be appends later
+    assignImpl(str, len, deleteStr);
+#ifdef SECURESTRING_REGISTRY
+    registerInstance();
+#endif
+}
+
+SecureString::SecureString(c_ssarr str, ssnr maxlen){
+    ssnr len = inputLength(str, maxlen, false);
+    init(len * 2); //make more room than neccessary, just in case there will be appends later
+    assignImpl((ssarr)str, len, false);
+#ifdef SECURESTRING_REGISTRY
+    registerInstance();
+#endif
+}
+
+SecureString::SecureString(ssarr str, ssnr maxlen, Capacity capacity, bool deleteStr, bool allowNull){
+    ssnr len = inputLength(str, maxlen, allowNull);
+    init(std::max(len, capacity.size));
+    assignImpl(str, len, deleteStr);
+#ifdef SECURESTRING_REGISTRY
+    registerInstance();
+#endif
+}
+
+SecureString::SecureString(c_ssarr str, ssnr maxlen, Capacity capacity){
+    ssnr len = inputLength(str, maxlen, false);
+    init(std::max(len, capacity.size));
+    assignImpl((ssarr)str, len, false);
+#ifdef SECURESTRING_REGISTRY
+    registerInstance();
+#endif
+}
+
+SecureString::SecureString(std::string&& str){
+    init(str.size() * 2); //make more room than neccessary, just in case there will be appends later
+    assignImpl(&str[0], str.size(), false, true);
+    wipeContainer(str);
+#ifdef SECURESTRING_REGISTRY
+    registerInstance();
+#endif
+}
+
+SecureString::SecureString(std::vector<char>&& str){
+    init(str.size() * 2); //make more room than neccessary, just in case there will be appends later
+    assignImpl(str.data(), str.size(), false, true);
+    wipeContainer(str);
+#ifdef SECURESTRING_REGISTRY
+    registerInstance();
+#endif
+}
+
+SecureString::SecureString(const SecureString& src){
+    init(src.length() * 2); //make more room than neccessary, just in case there will be appends later
+    assign(src);
+#ifdef SECURESTRING_REGISTRY
+    registerInstance();
+#endif
+}
+
+SecureString::SecureString(const SecureString& src, MemoryResource& resource){
+    init(src.length() * 2, &resource); //make more room than neccessary, just in case there will be appends later
+    assign(src);
+#ifdef SECURESTRING_REGISTRY
+    registerInstance();
+#endif
+}
+
+SecureString::~SecureString(void)
+{
+#ifdef SECURESTRING_REGISTRY
+    unregisterInstance();
+#endif
+
+    //Destroy all unsecured data
+    UnsecuredStringFinished(); //is already thread safe
+
+    __securestring_thread_lock();
+    //Zero out all data
+    memset(_data, 0, allocated());
+    memset(_key, 0, allocated());
+    _length = 0;
+    _allocated = 0;
+
+    //deallocate arrays
+    releaseStorage();
+#ifdef SECURESTRING_KEEP_PLAINTEXT_DEBUG_COPY
+    releaseBytes(_debug_plaintextcopy, _debug_plaintextsize, DEBUGCOPY, _resource);
+#endif
+    objectCounter.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void SecureString::init(MemoryResource* resource){
+    __securestring_thread_lock();
+    _resource = resource ? resource : defaultMemoryResource();
+    _data = allocateBytes(sizeof(ssnr), STORAGE, _resource);
+    _key = allocateBytes(sizeof(ssnr), STORAGE, _resource);
+    //fill key with zeros, this keeps the length() and allocated() from failing before any call to allocate(x)
+    *((ssnr*)_data) = 0;
+    *((ssnr*)_key) = 0;
+    _length = 0;
+    _allocated = 0;
+    _storagesize = sizeof(ssnr);
+    _checksum = 0;
+    _plaintextcopy = NULL;
+#ifdef SECURESTRING_KEEP_PLAINTEXT_DEBUG_COPY
+    _debug_plaintextcopy = NULL;
+    _debug_plaintextsize = 0;
+#endif
+    _datadeleter = NULL;
+    resetLinefeedPosition();
+    objectCounter.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SecureString::init(ssnr size, MemoryResource* resource){
+    //same as init(), but the arrays are allocated directly with the final size
+    //instead of through a placeholder
+    _resource = resource ? resource : defaultMemoryResource();
+    _data = NULL;
+    _key = NULL;
+    _checksum = 0;
+    _plaintextcopy = NULL;
+#ifdef SECURESTRING_KEEP_PLAINTEXT_DEBUG_COPY
+    _debug_plaintextcopy = NULL;
+    _debug_plaintextsize = 0;
+#endif
+    _datadeleter = NULL;
+    allocateImpl(size, false);
+    resetLinefeedPosition();
+    objectCounter.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SecureString::allocate(ssnr size){
+    __securestring_thread_lock();
+    allocateImpl(size);
+}
+
+void SecureString::shrinkToFit(){
+    __securestring_thread_lock();
+    allocateImpl(0);
+}
+
+void SecureString::allocateImpl(ssnr size, bool preserve){
+    //store the length of the string, unless the content is to be dropped
+    ssnr strlen = preserve ? length() : 0;
+    ssnr nrOfOldAllocatedBytes = _key ? allocated() : 0;
+    ssnr nrToCopy = preserve ? nrOfOldAllocatedBytes : 0;
+
+    //increase size by one to include last '\0'
+    size += 1;
+    //the new array must at least be able to hold a key the size of ssnr
+    if (size <= sizeof(ssnr)){
+        size = sizeof(ssnr)+1; //include last '\0'
+    }
+    //check if new size is larger than current string length
+    if (size <= strlen){
+        size = strlen + 1; //include last '\0'
+    }
+    size = storageClass(size);
+
+    //make sure the new arrays fit in the budget (the old ones are still alive)
+    reserveStorage(2 * (uint64_t)size);
+
+    //create the new arrays
+    ssarr newdata = allocateBytes(size, STORAGE, _resource);
+    ssarr newkey = allocateBytes(size, STORAGE, _resource);
+
+    //fill the key array with random data one block at a time (the arrays are
+    //a multiple of the block size, so there is no partial block), and in the same
+    //pass re-encode the existing data with the new key and zero out the old
+    //key and data behind it, the rest of the data array is written as a
+    //mirror (xor equals zero).
+    //After this the old key and data is zeroed out (length() and allocate() will not work)
+    KeyStream& keystream = threadKeyStream();
+    ssbyte block[KeyStream::BLOCK];
+    for (ssnr i = 0; i < size; i += KeyStream::BLOCK){
+        keystream.generate((uint8_t*)block);
+        ssnr copy = (i < nrToCopy) ? std::min((ssnr)KeyStream::BLOCK, nrToCopy - i) : 0;
+        for (ssnr j = 0; j < copy; j++){
+            newkey[i + j] = block[j];
+            newdata[i + j] = block[j] ^ (_key[i + j] ^ _data[i + j]);
+            _data[i + j] = 0;
+            _key[i + j] = 0;
+        }
+        for (ssnr j = copy; j < KeyStream::BLOCK; j++){
+            newkey[i + j] = block[j];
+            newdata[i + j] = block[j];
+        }
+    }
+    volatileZero(block, sizeof(block));
+
+    //zero out whatever was not copied, when shrinking the old arrays extend
+    //past the new ones, and nothing was copied if the content was dropped
+    ssnr nrWiped = std::min(nrToCopy, size);
+    if (nrOfOldAllocatedBytes > nrWiped){
+        memset(_data + nrWiped, 0, nrOfOldAllocatedBytes - nrWiped);
+        memset(_key + nrWiped, 0, nrOfOldAllocatedBytes - nrWiped);
+    }
+    _length = strlen ^ ((ssnr)*newkey);
+    _allocated = (size - 1) ^ ((ssnr)*newkey);
+
+    //deallocate the old arrays
+    releaseStorage();
+    _data = newdata;
+    _key = newkey;
+    _storagesize = size;
+    _datadeleter = NULL;
+}
+
+void SecureString::append(ssarr str, ssnr maxlen, bool deleteStr, bool allowNull){
+    __securestring_thread_lock();
+    ssnr len = inputLength(str, maxlen, allowNull);
+
+    ssnr oldlen = length();
+    //calculate the new total length
+    ssnr totlen = oldlen + len;
+    //Check if there is room for the new string
+    if (totlen > allocated()){
+        allocateImpl(totlen * 2); //make more room than neccessary, just in case there will be more appends later
+    }
+    for (ssnr i = 0; i < len; i++){
+        //Store in  array
+        _data[oldlen + i] = _key[oldlen + i] ^ str[i];
+        //recalculate checksum
+        if (oldlen == 0 && i == 0)
+            _checksum = crc32buf(&(str[i]), 1);
+        else
+            _checksum = updateCRC32(str[i], _checksum);
+    }
+    _length = ((ssnr)*_key) ^ totlen;
+    if (deleteStr){
+        memset(str, 0, len);
+        delete[] str;
+    }
+    resetLinefeedPosition();
+
+#ifdef SECURESTRING_KEEP_PLAINTEXT_DEBUG_COPY
+    _store_debug_plaintextcopy();
+#endif
+}
+
+void SecureString::append(c_ssarr str, ssnr maxlen){
+    append((ssarr)str, maxlen, false);
+}
+
+void SecureString::append(const SecureString& str){
+    __securestring_thread_lock_pair(str);
+    ssnr len = str.length();
+    ssnr oldlen = this->length();
+    ssnr totlen = oldlen + len;
+    if (totlen > this->allocated()){
+        this->allocateImpl(totlen * 2); //make more room than neccessary, just in case there will be more appends later
+    }
+    for (ssnr i = 0; i < len; i++){
+        ssbyte c = str._data[i] ^ str._key[i];
+        //Store in array
+        this->_data[i + oldlen] = this->_key[oldlen + i] ^ c;
+        //recalculate checksum
+        if (oldlen == 0 && i == 0)
+            _checksum = crc32buf(&c, 1);
+        else
+            _checksum = updateCRC32(c, _checksum);
+    }
+    _length = ((ssnr)*_key) ^ totlen;
+    resetLinefeedPosition();
+
+#ifdef SECURESTRING_KEEP_PLAINTEXT_DEBUG_COPY
+    _store_debug_plaintextcopy();
+#endif
+}
+
+void SecureString::assign(ssarr str, ssnr maxlen, bool deleteStr, bool allowNull){
+    __securestring_thread_lock();
+    assignImpl(str, inputLength(str, maxlen, allowNull), deleteStr);
+}
+
+void SecureString::assignImpl(ssarr str, ssnr len, bool deleteStr, bool wipeStr){
+    ssnr oldlen = length();
+
+    //allocate enough space, the old content is replaced so it is wiped
+    //instead of being carried over to the new arrays
+    if (len > allocated()){
+        allocateImpl(len * 2, false); //make more room than neccessary, just in case there will be more appends later
+        oldlen = 0;
+    }
+    //store, calculate the checksum and wipe the input in a single pass
+    bool wipe = deleteStr || wipeStr;
+    DWORD crc = 0;
+    for (ssnr i = 0; i < len; i++){
+        _data[i] = _key[i] ^ str[i];
+        crc = updateCRC32(str[i], crc);
+        if (wipe)
+            str[i] = 0;
+    }
+    //remove what is left of the old data, including the last '\0'
+    memcpy(_data + len, _key + len, std::max(oldlen, len) - len + 1);
+    _length = ((ssnr)*_key) ^ len;
+    _checksum = crc;
+
+    if (deleteStr){
+        delete[] str;
+    }
+    resetLinefeedPosition();
+
+#ifdef SECURESTRING_KEEP_PLAINTEXT_DEBUG_COPY
+    _store_debug_plaintextcopy();
+#endif
+}
+
+void SecureString::assign(c_ssarr str, ssnr maxlen){
+    assign((ssarr)str, maxlen, false);
+}
+
+void SecureString::assign(std::string&& str){
+    __securestring_thread_lock();
+    assignImpl(&str[0], str.size(), false, true);
+    wipeContainer(str);
+}
+
+void SecureString::assign(std::vector<char>&& str){
+    __securestring_thread_lock();
+    assignImpl(str.data(), str.size(), false, true);
+    wipeContainer(str);
+}
+
+void SecureString::adopt(ssarr buf, ssnr len, Deleter deleter){
+    __securestring_thread_lock();
+    //the key must be able to hold a ssnr, see allocateImpl()
+    if (len < sizeof(ssnr)){
+        try {
+            assignImpl(buf, len, false);
+        } catch (...) {
+            volatileZero(buf, len + 1);
+            deleter(buf, len + 1);
+            throw;
+        }
+        memset(buf, 0, len + 1);
+        deleter(buf, len + 1);
+        return;
+    }
+
+    ssnr size = len + 1; //include last '\0'
+    ssarr newkey;
+    try {
+        reserveStorage(size);
+        newkey = allocateBytes(size, STORAGE, _resource);
+    } catch (...) {
+        //the buffer has been handed over, it must not leak the plaintext when
+        //the string can not take it
+        volatileZero(buf, size);
+        deleter(buf, size);
+        throw;
+    }
+
+    //generate the key and obfuscate the buffer in place, the checksum is
+    //calculated in the same pass while the plaintext is at hand
+    KeyStream& keystream = threadKeyStream();
+    ssbyte block[KeyStream::BLOCK];
+    DWORD crc = 0;
+    for (ssnr i = 0; i < size; i += KeyStream::BLOCK){
+        keystream.generate((uint8_t*)block);
+        ssnr n = std::min((ssnr)KeyStream::BLOCK, size - i);
+        for (ssnr j = 0; j < n; j++){
+            newkey[i + j] = block[j];
+            if (i + j < len)
+                crc = updateCRC32(buf[i + j], crc);
+            //the last '\0' is stored as a mirror of the key
+            buf[i + j] = (i + j < len) ? buf[i + j] ^ block[j] : block[j];
+        }
+    }
+    volatileZero(block, sizeof(block));
+
+    //the old content is replaced, wipe it and release its arrays
+    memset(_data, 0, storageSize());
+    memset(_key, 0, storageSize());
+    releaseStorage();
+    _data = buf;
+    _key = newkey;
+    _storagesize = size;
+    _datadeleter = deleter;
+    _length = ((ssnr)*_key) ^ len;
+    _allocated = ((ssnr)*_key) ^ len;
+    _checksum = crc;
+    resetLinefeedPosition();
+
+#ifdef SECURESTRING_KEEP_PLAINTEXT_DEBUG_COPY
+    _store_debug_plaintextcopy();
+#endif
+}
+
+SecureString::ssnr SecureString::inputLength(c_ssarr str, ssnr maxlen, bool allowNull){
+    //set len to strlen(str) or maxlen, wichever is lowest (except if maxlen is 0 then set len to strlen(0))
+    //ssnr len = (maxlen == 0) ? strlen(str) : std::min((ssnr)strlen(str), maxlen);
+    ssnr len;
+
+    if (maxlen == 0)
+    {
+        len = strlen(str);
+    }
+    else if (allowNull)
+    {
+        len = maxlen;
+    }
+    else
+    {
+        len = std::min((ssnr)strlen(str), maxlen);
+    }
+    return len;
+}
+
+void SecureString::assign(const SecureString& str){
+    __securestring_thread_lock_pair(str);
+    ssnr oldlen = length();
+
+    //allocate enough space, the old content is replaced so it is wiped
+    //instead of being carried over to the new arrays
+    ssnr len = str.length();
+    if (len > this->allocated()){
+        this->allocateImpl(len * 2, false); //make more room than neccessary, just in case there will be more appends later
+        oldlen = 0;
+    }
+    for (ssnr i = 0; i < len; i++){
+        this->_data[i] = this->_key[i] ^ (str._key[i] ^ str._data[i]);
+    }
+    //remove what is left of the old data, including the last '\0'
+    memcpy(_data + len, _key + len, std::max(oldlen, len) - len + 1);
+    _length = ((ssnr)*_key) ^ len;
+
+    //checksum is already calculated by other instance, no need to do it again
+    _checksum = str._checksum;
+
+    resetLinefeedPosition();
+
+#ifdef SECURESTRING_KEEP_PLAINTEXT_DEBUG_COPY
+    _store_debug_plaintextcopy();
+#endif
+}
+
+SecureString::c_ssarr SecureString::getUnsecureString(unsigned int timeout){
+    __securestring_thread_lock();
+    c_ssarr ret = getUnsecureStringImpl();
+    if (ret != NULL)
+        schedulePlaintextDeadline(timeout);
+    return ret;
+}
+SecureString::c_ssarr SecureString::getUnsecureStringImpl(){
+    //there can only be one unsecure plaintext copy at a time
+    if (_plaintextcopy != NULL)
+        return NULL;
+    ssnr size = length();
+    ssarr copy = allocatePlaintext(size + 1);
+    copy[size] = '\0';
+    for (ssnr i = 0; i < size; i++){
+        copy[i] = _key[i] ^ _data[i];
+    }
+    return copy;
+}
+
+SecureString::ssarr SecureString::allocatePlaintext(ssnr size){
+    ssarr block = allocateBytes(sizeof(PlaintextCopy) + size, PLAINTEXT, _resource);
+    _plaintextcopy = new (block) PlaintextCopy();
+    _plaintextcopy->size = size;
+    _plaintextcopy->mutableCopy = false;
+    _plaintextcopy->deadline = false;
+    _plaintextcopy->expired = false;
+    return _plaintextcopy->bytes();
+}
+
+SecureString::ssarr SecureString::getUnsecureStringM(unsigned int timeout){
+    __securestring_thread_lock();
+    ssarr ret = (ssarr)getUnsecureStringImpl();
+    if (ret != NULL){
+        _plaintextcopy->mutableCopy = true;
+        schedulePlaintextDeadline(timeout);
+    }
+    return ret;
+}
+
+void SecureString::schedulePlaintextDeadline(unsigned int timeout){
+    if (timeout == 0)
+        timeout = plaintextTimeout.load(std::memory_order_relaxed);
+    if (timeout == 0)
+        return;
+    _plaintextcopy->deadline = true;
+    PlaintextReaper::instance().schedule(_plaintextcopy, timeout);
+}
+
+void SecureString::setPlaintextTimeout(unsigned int timeout){
+    plaintextTimeout.store(timeout, std::memory_order_relaxed);
+}
+
+SecureString::c_ssarr SecureString::getUnsecureNextline(unsigned int timeout){
+    __securestring_thread_lock();
+    //there can only be one unsecure plaintext copy at a time
+    if (_plaintextcopy != NULL)
+        return NULL;
+
+    int startPos = (((ssnr)*_key) ^ _nexlinefeedposition);
+    int tLen = ((ssnr)*_key) ^ _length;
+    int sLen = 0;
+    int CRLF = 0;
+
+    //Find next linefeed
+    for (int i = startPos; i < tLen; i++){
+        if (at(i) == '\n'){
+            sLen = i - startPos;
+            break;
+        }
+        else if (at(i) == '\r'){
+            sLen = i - startPos;
+            if (at(i + 1) == '\n'){
+                CRLF = 1;
+            }
+            break;
+        }
+    }
+
+    //create new buffert
+    ssarr line = allocatePlaintext(sLen + 1);
+
+    //copy text over to the unsecured buffer
+    for (int i = 0; i < sLen; i++){
+        line[i] = _key[startPos + i] ^ _data[startPos + i];
+    }
+    line[sLen] = '\0';
+
+    _nexlinefeedposition = ((ssnr)*_key) ^ (startPos + sLen + 1 + CRLF);
+
+    schedulePlaintextDeadline(timeout);
+    return line;
+}
+
+void SecureString::UnsecuredStringFinished(){
+    __securestring_thread_lock();
+    if (_plaintextcopy == NULL)
+        return;
+    PlaintextCopy* copy = _plaintextcopy;
+    bool expired = false;
+    if (copy->deadline){
+        expired = PlaintextReaper::instance().cancel(copy);
+    }
+    //an expired copy has been wiped, there are no changes left to import
+    if (copy->mutableCopy && !expired){
+        assign(copy->bytes(), 0, false);
+    }
+    size_t size = sizeof(PlaintextCopy) + copy->size;
+    memset(copy->bytes(), 0, copy->size);
+    copy->~PlaintextCopy();
+    releaseBytes((ssarr)copy, size, PLAINTEXT, _resource);
+    _plaintextcopy = NULL;
+}
+
+bool SecureString::equals(const SecureString& s2) const{
+    __securestring_thread_lock_pair(s2);
+    if (s2.length() != this->length()){
+        return false;
+    }
+    return _checksum == s2._checksum;
+}
+
+bool SecureString::equals(const char* s2) const{
+    __securestring_thread_lock();
+    unsigned int len = this->length();
+    if (strlen(s2) != len){
+        return false;
+    }
+    ssnr s2_checksum = crc32buf(s2, len);
+    return _checksum == s2_checksum;
+}
+
+
+bool SecureString::verify() const{
+    __securestring_thread_lock();
+    ssnr len = length();
+    //a damaged first key byte also damages the length, never read past the arrays
+    if (len > allocated() || allocated() >= _storagesize)
+        return false;
+    DWORD crc = 0;
+    for (ssnr i = 0; i < len; i++){
+        crc = updateCRC32(_key[i] ^ _data[i], crc);
+    }
+    return crc == _checksum;
+}
+
+SecureString::MemoryUsage SecureString::memoryUsage() const{
+    __securestring_thread_lock();
+    MemoryUsage usage;
+    usage.object = sizeof(SecureString);
+    usage.storage = 2 * storageSize();
+    usage.slack = 2 * (allocated() - length());
+    usage.plaintext = _plaintextcopy ? sizeof(PlaintextCopy) + _plaintextcopy->size : 0;
+#ifdef SECURESTRING_KEEP_PLAINTEXT_DEBUG_COPY
+    usage.debug = _debug_plaintextsize;
+#else
+    usage.debug = 0;
+#endif
+    usage.blocks = 2 + (usage.plaintext ? 1 : 0) + (usage.debug ? 1 : 0);
+    usage.total = usage.object + usage.storage + usage.plaintext + usage.debug;
+    return usage;
+}
+
+SecureString::ssnr SecureString::storageSize() const{
+    return _storagesize;
+}
+
+void SecureString::releaseStorage(){
+    if (_datadeleter != NULL){
+        //an adopted data array goes back to its owner, wiped
+        memset(_data, 0, _storagesize);
+        _datadeleter(_data, _storagesize);
+    }
+    else {
+        releaseBytes(_data, _storagesize, STORAGE, _resource);
+    }
+    releaseBytes(_key, _storagesize, STORAGE, _resource);
+}
+
+void SecureString::deleteArray(ssarr buf, ssnr){
+    delete[] buf;
+}
+
+void SecureString::wipeMemory(void* bytes, size_t size){
+    volatileZero(bytes, size);
+}
+
+void SecureString::setMemoryBudget(uint64_t bytes){
+    storageBudget.store(bytes, std::memory_order_relaxed);
+}
+
+uint64_t SecureString::memoryBudget(){
+    return storageBudget.load(std::memory_order_relaxed);
+}
+
+void SecureString::addMemoryPressureCallback(MemoryPressureCallback callback, void* context){
+    std::lock_guard<std::mutex> lock(pressureCallbacksLock);
+    pressureCallbacks().push_back(std::make_pair(callback, context));
+}
+
+void SecureString::removeMemoryPressureCallback(MemoryPressureCallback callback, void* context){
+    std::lock_guard<std::mutex> lock(pressureCallbacksLock);
+    PressureCallbacks& callbacks = pressureCallbacks();
+    callbacks.erase(std::remove(callbacks.begin(), callbacks.end(), std::make_pair(callback, context)),
+                    callbacks.end());
+}
+
+void SecureString::reserveStorage(uint64_t bytes){
+    uint64_t budget = storageBudget.load(std::memory_order_relaxed);
+    //callbacks free memory by shrinking or destroying strings, which needs
+    //allocations of its own, so the budget is not enforced inside them
+    if (budget == 0 || inPressureCallback)
+        return;
+    if (liveBytes[STORAGE].load(std::memory_order_relaxed) + bytes <= budget)
+        return;
+
+    //give the application a chance to free some memory, one callback at a time
+    PressureCallbacks callbacks;
+    {
+        std::lock_guard<std::mutex> lock(pressureCallbacksLock);
+        callbacks = pressureCallbacks();
+    }
+    {
+        PressureCallbackScope scope;
+        for (size_t i = 0; i < callbacks.size(); i++){
+            callbacks[i].first(bytes, budget, callbacks[i].second);
+            if (liveBytes[STORAGE].load(std::memory_order_relaxed) + bytes <= budget)
+                return;
+        }
+    }
+    throw std::bad_alloc();
+}
+
+SecureString::Statistics SecureString::statistics(){
+    Statistics stats;
+    stats.allocations = allocationCounter.load(std::memory_order_relaxed);
+    stats.deallocations = deallocationCounter.load(std::memory_order_relaxed);
+    stats.objects = objectCounter.load(std::memory_order_relaxed);
+    stats.storageBytes = liveBytes[STORAGE].load(std::memory_order_relaxed);
+    stats.plaintextBytes = liveBytes[PLAINTEXT].load(std::memory_order_relaxed);
+    stats.debugBytes = liveBytes[DEBUGCOPY].load(std::memory_order_relaxed);
+    stats.frozenBytes = liveBytes[FROZEN].load(std::memory_order_relaxed);
+    stats.expiredPlaintextCopies = expiredPlaintextCounter.load(std::memory_order_relaxed);
+    stats.scrubbedStrings = scrubbedCounter.load(std::memory_order_relaxed);
+    stats.corruptedStrings = corruptedCounter.load(std::memory_order_relaxed);
+    return stats;
+}
+
+SecureString::ssarr SecureString::allocateBytes(size_t size, MemoryCategory category, MemoryResource* resource){
+    ssarr bytes = (ssarr)resource->allocate(size, alignment(category));
+    allocationCounter.fetch_add(1, std::memory_order_relaxed);
+    liveBytes[category].fetch_add(size, std::memory_order_relaxed);
+    return bytes;
+}
+
+void SecureString::releaseBytes(ssarr bytes, size_t size, MemoryCategory category, MemoryResource* resource){
+    if (bytes == NULL)
+        return;
+    deallocationCounter.fetch_add(1, std::memory_order_relaxed);
+    liveBytes[category].fetch_sub(size, std::memory_order_relaxed);
+    resource->deallocate(bytes, size, alignment(category));
+}
+
+SecureString::ssnr SecureString::storageClass(ssnr size){
+    if (size > STORAGE_LARGE)
+        return (size + STORAGE_LARGE - 1) / STORAGE_LARGE * STORAGE_LARGE;
+    ssnr bucket = STORAGE_ALIGNMENT;
+    while (bucket < size){
+        bucket <<= 1;
+    }
+    return bucket;
+}
+
+size_t SecureString::alignment(MemoryCategory category){
+    return category == STORAGE ? STORAGE_ALIGNMENT : MemoryResource::DEFAULT_ALIGNMENT;
+}
+
+MemoryResource* SecureString::setDefaultMemoryResource(MemoryResource* resource){
+    return defaultResource.exchange(resource);
+}
+
+MemoryResource* SecureString::defaultMemoryResource(){
+    MemoryResource* resource = defaultResource.load();
+    if (resource != NULL)
+        return resource;
+#ifdef SECURESTRING_SECRET_STORAGE
+    return &SecretArena::instance();
+#else
+    return newDeleteResource();
+#endif
+}
+
+MemoryResource* SecureString::memoryResource() const{
+    return _resource;
+}
+
+#ifdef SECURESTRING_KEEP_PLAINTEXT_DEBUG_COPY
+void SecureString::_store_debug_plaintextcopy()
+{
+    releaseBytes(_debug_plaintextcopy, _debug_plaintextsize, DEBUGCOPY, _resource);
+    ssnr size = length();
+    _debug_plaintextcopy = allocateBytes(size + 1, DEBUGCOPY, _resource);
+    _debug_plaintextsize = size + 1;
+    _debug_plaintextcopy[size] = '\0';
+    for (ssnr i = 0; i < size; i++){
+        _debug_plaintextcopy[i] = _key[i] ^ _data[i];
+    }
+    
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//crc32 from http://web.archive.org/web/20080217222203/http://c.snippets.org/ //
+////////////////////////////////////////////////////////////////////////////////
+/* Crc - 32 BIT ANSI X3.66 CRC checksum files */
+
+/* Copyright (C) 1986 Gary S. Brown.  You may use this program, or
+   code or tables extracted from it, as desired without restriction.*/
+
+#include <stdio.h>
+
+/* Need an unsigned type capable of holding 32 bits; */
+
+typedef DWORD UNS_32_BITS;
+
+#define UPDC32(octet,crc) (crc_32_tab[((crc)\
+    ^ ((BYTE)octet)) & 0xff] ^ ((crc) >> 8))
+
+static UNS_32_BITS crc_32_tab[] = { /* CRC polynomial 0xedb88320 */
+    0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
+    0xe963a535, 0x9e6495a3, 0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
+    0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91, 0x1db71064, 0x6ab020f2,
+    0xf3b97148, 0x84be41de, 0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
+    0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec, 0x14015c4f, 0x63066cd9,
+    0xfa0f3d63, 0x8d080df5, 0x3b6e20c8, 0x4c69105e, 0xd56041e4, 0xa2677172,
+    0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b, 0x35b5a8fa, 0x42b2986c,
+    0xdbbbc9d6, 0xacbcf940, 0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59,
+    0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423,
+    0xcfba9599, 0xb8bda50f, 0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924,
+    0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d, 0x76dc4190, 0x01db7106,
+    0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433,
+    0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818, 0x7f6a0dbb, 0x086d3d2d,
+    0x91646c97, 0xe6635c01, 0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e,
+    0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457, 0x65b0d9c6, 0x12b7e950,
+    0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65,
+    0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2, 0x4adfa541, 0x3dd895d7,
+    0xa4d1c46d, 0xd3d6f4fb, 0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0,
+    0x44042d73, 0x33031de5, 0xaa0a4c5f, 0xdd0d7cc9, 0x5005713c, 0x270241aa,
+    0xbe0b1010, 0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
+    0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17, 0x2eb40d81,
+    0xb7bd5c3b, 0xc0ba6cad, 0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a,
+    0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683, 0xe3630b12, 0x94643b84,
+    0x0d6d6a3e, 0x7a6a5aa8, 0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1,
+    0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb,
+    0x196c3671, 0x6e6b06e7, 0xfed41b76, 0x89d32be0, 0x10da7a5a, 0x67dd4acc,
+    0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5, 0xd6d6a3e8, 0xa1d1937e,
+    0x38d8c2c4, 0x4fdff252, 0xd1bb67f1, 0xa6bc5767, 0x3fb506dd, 0x48b2364b,
+    0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55,
+    0x316e8eef, 0x4669be79, 0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236,
+    0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f, 0xc5ba3bbe, 0xb2bd0b28,
+    0x2bb45a92, 0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d,
+    0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a, 0x9c0906a9, 0xeb0e363f,
+    0x72076785, 0x05005713, 0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38,
+    0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21, 0x86d3d2d4, 0xf1d4e242,
+    0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777,
+    0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c, 0x8f659eff, 0xf862ae69,
+    0x616bffd3, 0x166ccf45, 0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2,
+    0xa7672661, 0xd06016f7, 0x4969474d, 0x3e6e77db, 0xaed16a4a, 0xd9d65adc,
+    0x40df0b66, 0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
+    0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd70693,
+    0x54de5729, 0x23d967bf, 0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94,
+    0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
+};
+
+DWORD updateCRC32(unsigned char ch, DWORD crc)
+{
+    return ~UPDC32(ch, ~crc);
+}
+
+DWORD crc32buf(const char *buf, size_t len)
+{
+    register DWORD oldcrc32;
+
+    oldcrc32 = 0xFFFFFFFF;
+
+    for (; len; --len, ++buf)
+    {
+        oldcrc32 = UPDC32(*buf, oldcrc32);
+    }
+
+    return ~oldcrc32;
+
+}
@@ -24,24 +24,72 @@
  * This class considers takes the following compile time parameters:
  * SECURESTRING_NOT_THREADSAFE (default: not set)
  *     Specifies wheater or not all public methods will be protected with mutexes
+ * SECURESTRING_COMPACT_LOCK (default: not set)
+ *     Protects each string with a 4 byte CompactLock instead of a
+ *     std::recursive_mutex in the thread safe build
+ * SECURESTRING_STRIPED_LOCKS (default: not set)
+ *     Removes the lock from each string in the thread safe build, strings are
+ *     instead mapped by address to one of SECURESTRING_LOCK_STRIPES (default:
+ *     64, a power of two) cache line sized locks in a process wide table
  * SECURESTRING_OVERRIDE_DEFAULT_ALLOCATED (default: 80)
  *     Specifies the number of characters that is pre-allocated 
  *     by the default constructor
+ * SECURESTRING_NO_AESNI (default: not set)
+ *     Disables the AES-NI counter mode key generator that is otherwise used
+ *     when compiling with AES support (-maes), keys are then filled using rand()
+ * SECURESTRING_REGISTRY (default: not set)
+ *     Keeps a registry of all live instances, which enables wipeAll()
+ * SECURESTRING_SCRUBBER (default: not set)
+ *     Enables the background integrity scrubber, see startScrubber(). Implies
+ *     SECURESTRING_REGISTRY and requires SECURESTRING_THREADSAFE
+ * SECURESTRING_SECRET_STORAGE (default: not set)
+ *     Makes the SecretArena the built-in default memory resource, so that all
+ *     memory (key, data and plaintext copies) is allocated from memfd_secret
+ *     memory on Linux 5.14+ or mlock'ed memory otherwise, instead of the heap.
+ *     SecretArena.cpp must then be compiled in as well.
  */
 
 #ifndef SECURESTRING_H_INCLUDED
 #define SECURESTRING_H_INCLUDED
 
+#include "MemoryResource.h"
+
 #include <cstdlib>
 #include <stdint.h>
+#include <string>
+#include <vector>
 
 #ifdef SECURESTRING_THREADSAFE
 #include <mutex>
-# define __securestring_thread_lock() std::lock_guard<std::mutex> lock(mutex_lock)
+# ifdef SECURESTRING_COMPACT_LOCK
+#  include "CompactLock.h"
+#  define __securestring_lock_type Caelus::Utilities::CompactLock
+# else
+#  define __securestring_lock_type std::recursive_mutex
+# endif
+# ifdef SECURESTRING_STRIPED_LOCKS
+#  ifndef SECURESTRING_LOCK_STRIPES
+#   define SECURESTRING_LOCK_STRIPES 64
+#  endif
+# endif
+# define __securestring_thread_lock() std::lock_guard<__securestring_lock_type> lock(objectLock())
 #else
 # define __securestring_thread_lock()
 #endif
 
+#ifdef SECURESTRING_SCRUBBER
+# ifndef SECURESTRING_THREADSAFE
+#  error "SECURESTRING_SCRUBBER requires SECURESTRING_THREADSAFE"
+# endif
+# ifndef SECURESTRING_REGISTRY
+#  define SECURESTRING_REGISTRY
+# endif
+#endif
+
+#if defined(SECURESTRING_SECRET_STORAGE) && !defined(__linux__)
+# error "SECURESTRING_SECRET_STORAGE requires Linux"
+#endif
+
 #ifdef SECURESTRING_DEBUG
 #define SECURESTRING_KEEP_PLAINTEXT_DEBUG_COPY
 #endif
@@ -49,6 +97,9 @@
 namespace Caelus {
     namespace Utilities {
 
+        struct PlaintextCopy;
+        struct RegistryShard;
+
         /**
          * SecureString class, this is a container that does not keep strings in plain
          * text in memory. The contents are not encrypted, they are only obfuscated.
@@ -62,6 +113,93 @@ namespace Caelus {
             typedef char* ssarr;
             typedef const char* c_ssarr;
 
+            /**
+             * The capacity argument of the reserving constructors. It is a
+             * separate type so that it can not be mistaken for maxlen or deleteStr.
+             * A capacity smaller than the string (e.g. 0) allocates just the
+             * length of the string. Storage is always rounded up to a size class,
+             * see allocate().
+             */
+            struct Capacity {
+                explicit Capacity(ssnr size) : size(size) {}
+                ssnr size;
+            };
+
+            /**
+             * Process wide counters of the heap blocks allocated and released by
+             * SecureString and FrozenSecureString. Comparing two snapshots shows
+             * how many allocations an operation performed. The byte counters are
+             * the live heap bytes per category, excluding allocator overhead.
+             */
+            struct Statistics {
+                uint64_t allocations;
+                uint64_t deallocations;
+                uint64_t objects;        //live SecureString instances
+                uint64_t storageBytes;   //key and data arrays
+                uint64_t plaintextBytes; //unsecured plaintext copies
+                uint64_t debugBytes;     //plaintext debug copies (SECURESTRING_DEBUG)
+                uint64_t frozenBytes;    //FrozenSecureString blocks
+                uint64_t expiredPlaintextCopies; //copies wiped by their deadline
+                uint64_t scrubbedStrings;  //integrity checks by the scrubber
+                uint64_t corruptedStrings; //failed integrity checks
+            };
+
+            /**
+             * Called by the integrity scrubber for a string whose contents no longer
+             * match its checksum. It runs on the scrubber thread while the string is
+             * locked, so it may read the string but must not create or destroy any
+             * SecureString. A corrupted string is reported again on every pass until
+             * it is reassigned or destroyed.
+             */
+            typedef void (*CorruptionCallback)(const SecureString& str, void* context);
+
+            /**
+             * Releases a buffer that was handed over with adopt(). The buffer has
+             * been zeroed when this is called.
+             */
+            typedef void (*Deleter)(ssarr buf, ssnr size);
+
+            /**
+             * The default Deleter of adopt(), performs delete[] on the buffer.
+             */
+            static void deleteArray(ssarr buf, ssnr size);
+
+            /**
+             * This zeroes a block of memory with volatile stores, which the compiler
+             * can not remove even when the memory is released or goes out of scope
+             * right after, e.g. a stack buffer that held plaintext.
+             * It is async-signal-safe.
+             * @param bytes - the memory to zero
+             * @param size - the number of bytes
+             */
+            static void wipeMemory(void* bytes, size_t size);
+
+            /**
+             * Called when an allocation would exceed the memory budget, see
+             * setMemoryBudget(). The callback should release SecureString storage,
+             * e.g. by calling shrinkToFit() or destroying cached strings. It must not
+             * use the string that is being grown, which is locked at the time.
+             * @param needed - bytes of storage that are about to be allocated
+             * @param budget - the current budget
+             * @param context - the context pointer given at registration
+             */
+            typedef void (*MemoryPressureCallback)(uint64_t needed, uint64_t budget, void* context);
+
+            /**
+             * The memory held by a single SecureString. Heap sizes are the
+             * requested sizes, add the allocator overhead for each of the blocks
+             * to get the real cost.
+             */
+            struct MemoryUsage {
+                size_t object;    //sizeof(SecureString), including the mutex if any
+                size_t storage;   //key and data arrays
+                size_t slack;     //part of storage allocated beyond length()
+                size_t plaintext; //unsecured plaintext copy, if any
+                size_t debug;     //plaintext debug copy, if any
+                size_t blocks;    //number of heap blocks held
+                size_t total;     //object + storage + plaintext + debug
+            };
+
         public:
 
             /**
@@ -100,14 +238,88 @@ namespace Caelus {
              */
             SecureString(c_ssarr str, ssnr maxlen = 0);
 
-            /** Copy-constructor **/
+            /**
+             * Constructor:
+             * Creates a SecureString initialized with the contents of str, null
+             * characters included. The whole buffer of str, small string storage
+             * included, is zeroed while it is read and str is left empty.
+             * @param str - The string, consumed
+             */
+            SecureString(std::string&& str);
+
+            /**
+             * Constructor:
+             * Creates a SecureString initialized with the contents of str, null
+             * characters included. The whole buffer of str is zeroed while it is
+             * read and str is left empty.
+             * @param str - The characters, consumed
+             */
+            SecureString(std::vector<char>&& str);
+
+            /**
+             * Constructor:
+             * Creates a SecureString initialized with str as its contents, with
+             * capacity bytes allocated (or the length of str if that is
+             * larger, rounded up to a size class). The memory is allocated once,
+             * use Capacity(0) for strings that will not change after construction.
+             * OBS! This constructor performs delete on the str argument if
+             * deleteStr is true.
+             * @param str - The string
+             * @param maxlen - The strings max length, 0 means auto
+             * @param capacity - bytes of memory to be allocated
+             * @param deleteStr - performs delete on str if true
+             */
+            SecureString(ssarr str, ssnr maxlen, Capacity capacity, bool deleteStr = true, bool allowNull = false);
+
+            /**
+             * Constructor:
+             * Creates a SecureString initialized with str as its contents, with
+             * capacity bytes allocated (or the length of str if that is
+             * larger, rounded up to a size class). The memory is allocated once,
+             * use Capacity(0) for strings that will not change after construction.
+             * OBS! This constructor does not perform delete on its str argument
+             * due to it being 'const'
+             * @param str - The string
+             * @param maxlen - The strings max length, 0 means auto
+             * @param capacity - bytes of memory to be allocated
+             */
+            SecureString(c_ssarr str, ssnr maxlen, Capacity capacity);
+
+            /**
+             * Constructor:
+             * Creates an empty string that allocates all its memory from resource.
+             * @param resource - the memory resource, must outlive the string
+             */
+            explicit SecureString(MemoryResource& resource);
+
+            /**
+             * Constructor:
+             * Creates an empty string with size bytes pre allocated, that allocates
+             * all its memory from resource.
+             * @param size - bytes of memory to be allocated
+             * @param resource - the memory resource, must outlive the string
+             */
+            SecureString(ssnr size, MemoryResource& resource);
+
+            /**
+             * Copy-constructor, the copy allocates from the default memory resource
+             * (like std::pmr containers), not from the resource of the original.
+             **/
             SecureString(const SecureString&);
 
+            /**
+             * Copy-constructor that allocates from resource.
+             * @param src - the string to copy
+             * @param resource - the memory resource, must outlive the string
+             */
+            SecureString(const SecureString& src, MemoryResource& resource);
+
             /** Destructor **/
             ~SecureString(void);
 
             /**
              * This assigns a string to this string (replaces the content).
+             * Memory is only allocated if the string does not fit in allocated().
              * OBS! This method performs delete on the str argument if
              * deleteStr is true.
              * @param str - The string
@@ -118,6 +330,7 @@ namespace Caelus {
 
             /**
              * This assigns a string to this string (replaces the content).
+             * Memory is only allocated if the string does not fit in allocated().
              * OBS! This method does not perform delete on its str argument
              * due to it being 'const'
              * @param str - The string
@@ -127,10 +340,49 @@ namespace Caelus {
 
             /**
              * This assigns a string to this string (replaces the content)
+             * Memory is only allocated if the string does not fit in allocated().
              * @param str - The string to assign
              */
             void assign(const SecureString& str);
 
+            /**
+             * This assigns the contents of str to this string (replaces the content),
+             * null characters included. The whole buffer of str, small string storage
+             * included, is zeroed while it is read and str is left empty.
+             * Memory is only allocated if the string does not fit in allocated().
+             * @param str - The string, consumed
+             */
+            void assign(std::string&& str);
+
+            /**
+             * This assigns the contents of str to this string (replaces the content),
+             * null characters included. The whole buffer of str is zeroed while it is
+             * read and str is left empty.
+             * Memory is only allocated if the string does not fit in allocated().
+             * @param str - The characters, consumed
+             */
+            void assign(std::vector<char>&& str);
+
+            /**
+             * This takes over a buffer holding a plaintext string of len characters
+             * (replaces the content). The buffer is obfuscated in place and becomes
+             * the data array of this string, only the key is allocated, so large
+             * secrets are neither copied nor briefly stored twice.
+             * The buffer must be at least len + 1 bytes, the last byte is used for
+             * the terminating null character. It is zeroed and passed to deleter
+             * once the string no longer needs it, e.g. when it grows or is destroyed.
+             * Very short strings are copied and their buffer released right away.
+             * Unlike allocated storage the buffer is not padded to a size class.
+             * OBS! The caller must not touch buf after this call, also not when it
+             * throws: if the key can not be allocated, e.g. because the memory budget
+             * is exceeded, the buffer is zeroed and passed to deleter before
+             * std::bad_alloc is thrown, and the string is left unchanged.
+             * @param buf - The buffer to adopt
+             * @param len - The length of the string in buf, null characters are allowed
+             * @param deleter - releases buf, defaults to delete[]
+             */
+            void adopt(ssarr buf, ssnr len, Deleter deleter = deleteArray);
+
             /**
              * Assignment operator
              */
@@ -173,9 +425,12 @@ namespace Caelus {
              * When the copy is no longer needed call UnsecuredStringFinished() to
              * perform a safe delete on the string.
              * This copy is UnMutable and should thus not be modified!
+             * @param timeout - milliseconds after which the copy is wiped (zeroed) if
+             * UnsecuredStringFinished() has not been called, 0 means the default set
+             * with setPlaintextTimeout()
              * @return pointer to an unsecured plaintext string, NULL on failure
              */
-            c_ssarr getUnsecureString();
+            c_ssarr getUnsecureString(unsigned int timeout = 0);
 
             /**
              * This returns a pointer to a plaintext copy of the string.
@@ -190,9 +445,13 @@ namespace Caelus {
              * NOTE: The string length will be equal to length() and not allocated()
              * Increasing the length by writing past the end of the buffer will result
              * in heap corruption.
+             * If the copy is wiped by its deadline the modifications are lost.
+             * @param timeout - milliseconds after which the copy is wiped (zeroed) if
+             * UnsecuredStringFinished() has not been called, 0 means the default set
+             * with setPlaintextTimeout()
              * @return pointer to an unsecured plaintext string, NULL on failure
              */
-            ssarr getUnsecureStringM();
+            ssarr getUnsecureStringM(unsigned int timeout = 0);
 
             /**
              * This returns a pointer to a plaintext copy of the string, containing
@@ -203,9 +462,12 @@ namespace Caelus {
              * When the copy is no longer needed call UnsecuredStringFinished() to
              * perform a safe delete on the string.
              * This copy is UnMutable and should thus not be modified!
+             * @param timeout - milliseconds after which the copy is wiped (zeroed) if
+             * UnsecuredStringFinished() has not been called, 0 means the default set
+             * with setPlaintextTimeout()
              * @return pointer to an unsecured plaintext string, NULL on failure
              */
-            c_ssarr getUnsecureNextline();
+            c_ssarr getUnsecureNextline(unsigned int timeout = 0);
 
             /**
              * This performs a safe delete on the unsecured copy of this string. If
@@ -214,8 +476,73 @@ namespace Caelus {
              */
             void UnsecuredStringFinished();
 
+            /**
+             * This sets the process wide default deadline of plaintext copies. Copies
+             * that are still alive when it passes are wiped (zeroed) by a shared
+             * background thread and counted in Statistics::expiredPlaintextCopies,
+             * the memory itself is released by UnsecuredStringFinished() as usual.
+             * Deadlines are enforced with a granularity of 10 ms.
+             * @param timeout - the deadline in milliseconds, 0 means never (default)
+             */
+            static void setPlaintextTimeout(unsigned int timeout);
+
+#ifdef SECURESTRING_REGISTRY
+            /**
+             * This zeroes the contents, plaintext copies included, of every live
+             * SecureString in the process, leaving them as empty strings without
+             * capacity, so that the next write to a string re-keys it. It is
+             * async-signal-safe and meant for signal handlers and fatal error paths,
+             * the process is expected to terminate afterwards: strings that are in
+             * use by other threads at the same time may be left inconsistent.
+             * Outstanding plaintext copies are zeroed but stay allocated until
+             * UnsecuredStringFinished() is called.
+             * @return the number of strings wiped
+             */
+            static size_t wipeAll();
+#endif
+
+            /**
+             * This decodes the string and checks it against the stored checksum,
+             * which detects bit flips and stray writes to the key or data arrays.
+             * This never allocates memory.
+             * @return true - if the contents match the checksum
+             */
+            bool verify() const;
+
+#ifdef SECURESTRING_SCRUBBER
+            /**
+             * This starts a background thread that verify()s all live strings, a
+             * slice of at most budget microseconds every interval milliseconds.
+             * Strings that are locked by another thread are skipped until the next
+             * pass, so readers are never stalled by the scrubber. Calling it again
+             * replaces the settings of the running scrubber.
+             * @param interval - the time between two slices in milliseconds
+             * @param budget - the time spent in each slice in microseconds
+             * @param callback - reports corrupted strings, may be NULL
+             * @param context - passed on to the callback
+             */
+            static void startScrubber(unsigned int interval = 100, unsigned int budget = 500,
+                                      CorruptionCallback callback = NULL, void* context = NULL);
+
+            /**
+             * This stops the background scrubber and waits for its thread to exit.
+             */
+            static void stopScrubber();
+
+            /**
+             * This runs a single scrubber slice on the calling thread, continuing
+             * where the previous slice stopped.
+             * @param budget - the time to spend in microseconds
+             * @param callback - reports corrupted strings, may be NULL
+             * @param context - passed on to the callback
+             * @return the number of strings verified
+             */
+            static size_t scrub(unsigned int budget, CorruptionCallback callback = NULL, void* context = NULL);
+#endif
+
             /**
              * This returns a single character at position pos of the string.
+             * This never allocates memory.
              * @param pos - the position in the string to return
              * @return character at position pos, 0 on failure
              */
@@ -247,11 +574,20 @@ namespace Caelus {
 
             /**
              * This allocates a size block of memory for the string and transfers
-             * the current string to the new memory block.
+             * the current string to the new memory block. The block is aligned to
+             * 64 bytes and rounded up to a size class: the powers of two from 64
+             * bytes to 64 KiB, and multiples of 64 KiB above that. allocated()
+             * returns the resulting capacity, so it only hints at the length.
              * @param size
              */
             void allocate(ssnr size);
 
+            /**
+             * This reallocates the memory block to the smallest size class that fits
+             * the current string, releasing any room left for future appends.
+             */
+            void shrinkToFit();
+
             /**
              * This resets the position of the linefeed pointer, so that
              * the next cal to getUnsecureNextline() will return the first line
@@ -264,6 +600,7 @@ namespace Caelus {
 
             /**
              * This returns true if the argument contains an equal string
+             * This never allocates memory.
              * @param s2 - the string to compare with
              * @return true - if strings are equal
              */
@@ -271,6 +608,7 @@ namespace Caelus {
 
             /**
              * This returns true if the argument contains an equal string
+             * This never allocates memory.
              * @param s2 - the string to compare with
              * @return true - if strings are equal
              */
@@ -290,30 +628,152 @@ namespace Caelus {
                 return _checksum;
             }
 
+            /**
+             * This returns the memory used by this string.
+             * @return the memory usage broken down by category
+             */
+            MemoryUsage memoryUsage() const;
+
+            /**
+             * This returns a snapshot of the process wide allocation counters.
+             * @return the heap blocks allocated and released so far, and the
+             * bytes currently held by all instances
+             */
+            static Statistics statistics();
+
+            /**
+             * This sets a process wide limit on the bytes of key and data storage
+             * held by all SecureStrings (Statistics::storageBytes). When an allocation
+             * would exceed it, the memory pressure callbacks are called in the order
+             * they were added until enough memory is released, if it still does not
+             * fit std::bad_alloc is thrown and the string is left unchanged.
+             * The limit is checked before each allocation, strings growing in
+             * several threads at once may exceed it by one allocation each.
+             * @param bytes - the budget in bytes, 0 means unlimited (default)
+             */
+            static void setMemoryBudget(uint64_t bytes);
+
+            /**
+             * This returns the process wide memory budget
+             * @return the budget in bytes, 0 if unlimited
+             */
+            static uint64_t memoryBudget();
+
+            /**
+             * This sets the process wide memory resource that strings allocate from
+             * unless one is given to their constructor. It only affects strings
+             * created afterwards, each string keeps its resource for its lifetime,
+             * also when it is assigned to.
+             * @param resource - the new default, NULL restores the built-in one
+             * @return the previous default, NULL if it was the built-in one
+             */
+            static MemoryResource* setDefaultMemoryResource(MemoryResource* resource);
+
+            /**
+             * This returns the memory resource new strings allocate from, the
+             * built-in one is newDeleteResource(), or the SecretArena when compiled
+             * with SECURESTRING_SECRET_STORAGE.
+             * @return the default memory resource
+             */
+            static MemoryResource* defaultMemoryResource();
+
+            /**
+             * This returns the memory resource this string allocates from.
+             * @return the memory resource
+             */
+            MemoryResource* memoryResource() const;
+
+            /**
+             * This adds a callback that is called when an allocation would exceed
+             * the memory budget. Allocations made by the callback are not limited.
+             * @param callback - the function to call
+             * @param context - passed to the callback as is
+             */
+            static void addMemoryPressureCallback(MemoryPressureCallback callback, void* context = NULL);
+
+            /**
+             * This removes a callback added with addMemoryPressureCallback()
+             * @param callback - the function to remove
+             * @param context - the context it was added with
+             */
+            static void removeMemoryPressureCallback(MemoryPressureCallback callback, void* context = NULL);
+
         private:
-            void init();
+            friend class FrozenSecureString;
+
+            void init(MemoryResource* resource = NULL);
+            void init(ssnr size, MemoryResource* resource = NULL);
             
             c_ssarr getUnsecureStringImpl();
-            void allocateImpl(ssnr size);
+            void schedulePlaintextDeadline(unsigned int timeout);
+            ssarr allocatePlaintext(ssnr size);
+            void allocateImpl(ssnr size, bool preserve = true);
+            void assignImpl(ssarr str, ssnr len, bool deleteStr, bool wipeStr = false);
+            static ssnr inputLength(c_ssarr str, ssnr maxlen, bool allowNull);
+            enum MemoryCategory { STORAGE, PLAINTEXT, DEBUGCOPY, FROZEN };
+
+            ssnr storageSize() const;
+            void releaseStorage();
+            static void reserveStorage(uint64_t bytes);
+            static ssarr allocateBytes(size_t size, MemoryCategory category, MemoryResource* resource);
+            static void releaseBytes(ssarr bytes, size_t size, MemoryCategory category, MemoryResource* resource);
+            static size_t alignment(MemoryCategory category);
+            static ssnr storageClass(ssnr size);
+
+#ifdef SECURESTRING_THREADSAFE
+# ifdef SECURESTRING_STRIPED_LOCKS
+            static __securestring_lock_type& lockStripe(const SecureString* str);
+
+            //the lock that protects this string
+            __securestring_lock_type& objectLock() const{
+                return lockStripe(this);
+            }
+# else
+            //the lock that protects this string
+            __securestring_lock_type& objectLock() const{
+                return mutex_lock;
+            }
+# endif
+#endif
+
+#ifdef SECURESTRING_REGISTRY
+            void registerInstance();
+            void unregisterInstance();
+            void wipeImpl();
+
+            //intrusive list of the instances created by one thread
+            RegistryShard* _registryShard;
+            SecureString* _registryPrev;
+            SecureString* _registryNext;
+#endif
 
 #ifdef SECURESTRING_KEEP_PLAINTEXT_DEBUG_COPY
             ssarr _debug_plaintextcopy;
+            ssnr _debug_plaintextsize;
             void _store_debug_plaintextcopy();
 #endif
 
         private:
-            ssarr _plaintextcopy;
+            //the fields are ordered by size so that there is no padding, with the
+            //compact lock (or striped locks) a string fills exactly one 64 byte
+            //cache line
+            PlaintextCopy* _plaintextcopy;
+            MemoryResource* _resource;
             ssarr _data;
             ssarr _key;
+            //releases an adopted data array, NULL if it was allocated here
+            Deleter _datadeleter;
             ssnr _length;
             ssnr _allocated;
+            //the size of the key and data arrays, not obfuscated so that releasing
+            //and verifying them does not depend on the first key byte
+            ssnr _storagesize;
             ssnr _nexlinefeedposition;
             ssnr _checksum;
-            bool _mutableplaintextcopy;
 
-#ifdef SECURESTRING_THREADSAFE
+#if defined(SECURESTRING_THREADSAFE) && !defined(SECURESTRING_STRIPED_LOCKS)
             //only allow one thread to access this object at a time
-            mutable std::mutex mutex_lock;
+            mutable __securestring_lock_type mutex_lock;
 #endif
         };
     }
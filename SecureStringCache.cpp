@@ -0,0 +1,167 @@
+#include "SecureStringCache.h"
+
+#include <chrono>
+#include <functional>
+
+using namespace Caelus::Utilities;
+
+SecureStringCache::SecureStringCache(size_t capacity, unsigned int shards, unsigned int resolution){
+    _nrOfShards = shards ? shards : 1;
+    _resolution = resolution ? resolution : 1;
+    //the limit is enforced per shard, rounded up so that the total is at least capacity
+    _shardCapacity = capacity ? (capacity + _nrOfShards - 1) / _nrOfShards : 0;
+    _shards = new Shard[_nrOfShards];
+    uint64_t now = currentTick();
+    for (unsigned int i = 0; i < _nrOfShards; i++){
+        _shards[i].wheel.advance(now, onExpire, NULL);
+    }
+}
+
+SecureStringCache::~SecureStringCache(void){
+    clear();
+    delete[] _shards;
+}
+
+void SecureStringCache::put(const std::string& name, const SecureString& value, uint64_t ttl){
+    Shard& shard = shardFor(name);
+    std::lock_guard<std::mutex> lock(shard.lock);
+    advance(shard);
+
+    Entry* entry;
+    std::unordered_map<std::string, Entry*>::iterator it = shard.entries.find(name);
+    if (it != shard.entries.end()){
+        entry = it->second;
+        entry->value.assign(value);
+    }
+    else {
+        //the entry is filled in before it is published, so that nothing is left
+        //behind when copying the value throws
+        entry = new Entry();
+        try {
+            entry->name = name;
+            entry->value.assign(value);
+            entry->lruPrev = NULL;
+            entry->lruNext = NULL;
+            shard.entries[name] = entry;
+        } catch (...) {
+            delete entry;
+            throw;
+        }
+        //make room by evicting the least recently used entry
+        if (_shardCapacity && shard.entries.size() > _shardCapacity){
+            remove(shard, shard.lru->lruPrev);
+        }
+    }
+    touch(shard, entry);
+    //round up, an entry must never expire early
+    shard.wheel.schedule(entry, shard.wheel.now() + (ttl + _resolution - 1) / _resolution);
+}
+
+bool SecureStringCache::get(const std::string& name, SecureString& value){
+    Shard& shard = shardFor(name);
+    std::lock_guard<std::mutex> lock(shard.lock);
+    advance(shard);
+
+    std::unordered_map<std::string, Entry*>::iterator it = shard.entries.find(name);
+    if (it == shard.entries.end())
+        return false;
+    touch(shard, it->second);
+    value.assign(it->second->value);
+    return true;
+}
+
+bool SecureStringCache::erase(const std::string& name){
+    Shard& shard = shardFor(name);
+    std::lock_guard<std::mutex> lock(shard.lock);
+    advance(shard);
+
+    std::unordered_map<std::string, Entry*>::iterator it = shard.entries.find(name);
+    if (it == shard.entries.end())
+        return false;
+    remove(shard, it->second);
+    return true;
+}
+
+void SecureStringCache::clear(){
+    for (unsigned int i = 0; i < _nrOfShards; i++){
+        Shard& shard = _shards[i];
+        std::lock_guard<std::mutex> lock(shard.lock);
+        while (shard.lru != NULL){
+            remove(shard, shard.lru);
+        }
+    }
+}
+
+void SecureStringCache::expire(){
+    for (unsigned int i = 0; i < _nrOfShards; i++){
+        std::lock_guard<std::mutex> lock(_shards[i].lock);
+        advance(_shards[i]);
+    }
+}
+
+size_t SecureStringCache::size() const{
+    size_t size = 0;
+    for (unsigned int i = 0; i < _nrOfShards; i++){
+        std::lock_guard<std::mutex> lock(_shards[i].lock);
+        size += _shards[i].entries.size();
+    }
+    return size;
+}
+
+SecureStringCache::Shard& SecureStringCache::shardFor(const std::string& name){
+    return _shards[std::hash<std::string>()(name) % _nrOfShards];
+}
+
+uint64_t SecureStringCache::currentTick() const{
+    using namespace std::chrono;
+    uint64_t ms = duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+    return ms / _resolution;
+}
+
+void SecureStringCache::advance(Shard& shard){
+    std::pair<SecureStringCache*, Shard*> context(this, &shard);
+    shard.wheel.advance(currentTick(), onExpire, &context);
+}
+
+void SecureStringCache::onExpire(TimerWheel::Node* node, void* context){
+    std::pair<SecureStringCache*, Shard*>* target = (std::pair<SecureStringCache*, Shard*>*)context;
+    target->first->remove(*target->second, static_cast<Entry*>(node));
+}
+
+void SecureStringCache::remove(Shard& shard, Entry* entry){
+    shard.wheel.cancel(entry);
+    shard.entries.erase(entry->name);
+    if (entry->lruNext == entry){
+        shard.lru = NULL;
+    }
+    else {
+        entry->lruPrev->lruNext = entry->lruNext;
+        entry->lruNext->lruPrev = entry->lruPrev;
+        if (shard.lru == entry)
+            shard.lru = entry->lruNext;
+    }
+    //the SecureString destructor wipes the secret
+    delete entry;
+}
+
+void SecureStringCache::touch(Shard& shard, Entry* entry){
+    if (shard.lru == entry)
+        return;
+    //unlink, if already in the list
+    if (entry->lruNext != NULL){
+        entry->lruPrev->lruNext = entry->lruNext;
+        entry->lruNext->lruPrev = entry->lruPrev;
+    }
+    //link in first
+    if (shard.lru == NULL){
+        entry->lruPrev = entry;
+        entry->lruNext = entry;
+    }
+    else {
+        entry->lruNext = shard.lru;
+        entry->lruPrev = shard.lru->lruPrev;
+        shard.lru->lruPrev->lruNext = entry;
+        shard.lru->lruPrev = entry;
+    }
+    shard.lru = entry;
+}
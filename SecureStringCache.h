@@ -0,0 +1,142 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2014 Alexander Nilsson
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef SECURESTRINGCACHE_H_INCLUDED
+#define SECURESTRINGCACHE_H_INCLUDED
+
+#include "SecureString.h"
+#include "TimerWheel.h"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Caelus {
+    namespace Utilities {
+
+        /**
+         * SecureStringCache class, a thread safe cache of named SecureStrings with a
+         * time to live per entry and a least recently used limit on the number of
+         * entries. The cache is split into shards with a lock each, and every shard
+         * expires its entries with a TimerWheel as it is used, so expiry costs O(1)
+         * per entry and never sweeps the whole cache.
+         * Entries are destroyed, and thereby wiped, as soon as they expire or are
+         * evicted.
+         */
+        class SecureStringCache {
+        public:
+
+            /**
+             * Constructor:
+             * Creates an empty cache
+             * @param capacity - the maximum number of entries, 0 means unlimited
+             * @param shards - the number of independently locked shards
+             * @param resolution - the granularity of expiry in milliseconds,
+             * entries live for at most their ttl plus one resolution
+             */
+            SecureStringCache(size_t capacity = 0, unsigned int shards = 16, unsigned int resolution = 100);
+
+            /** Destructor **/
+            ~SecureStringCache(void);
+
+            /**
+             * This stores a copy of value under name, replacing any previous entry
+             * @param name - the name of the entry
+             * @param value - the secret to cache
+             * @param ttl - the time to live in milliseconds
+             */
+            void put(const std::string& name, const SecureString& value, uint64_t ttl);
+
+            /**
+             * This copies the entry called name into value, if it exists and has not
+             * expired. The entry becomes the most recently used one.
+             * @param name - the name of the entry
+             * @param value - receives the secret
+             * @return true if the entry was found
+             */
+            bool get(const std::string& name, SecureString& value);
+
+            /**
+             * This removes the entry called name
+             * @param name - the name of the entry
+             * @return true if the entry existed
+             */
+            bool erase(const std::string& name);
+
+            /**
+             * This removes all entries
+             */
+            void clear();
+
+            /**
+             * This removes all expired entries from every shard. Expired entries are
+             * otherwise removed when their shard is next used.
+             */
+            void expire();
+
+            /**
+             * This returns the number of entries, including expired entries that
+             * have not been removed yet
+             * @return number of entries
+             */
+            size_t size() const;
+
+        private:
+            struct Entry : TimerWheel::Node {
+                std::string name;
+                SecureString value;
+                Entry* lruPrev;
+                Entry* lruNext;
+            };
+
+            struct Shard {
+                Shard() : lru(NULL) {}
+
+                mutable std::mutex lock;
+                std::unordered_map<std::string, Entry*> entries;
+                TimerWheel wheel;
+                //circular list, most recently used first
+                Entry* lru;
+            };
+
+            Shard& shardFor(const std::string& name);
+            uint64_t currentTick() const;
+            void advance(Shard& shard);
+            void remove(Shard& shard, Entry* entry);
+            void touch(Shard& shard, Entry* entry);
+            static void onExpire(TimerWheel::Node* node, void* context);
+
+            //never copied
+            SecureStringCache(const SecureStringCache&);
+            SecureStringCache& operator= (const SecureStringCache&);
+
+        private:
+            Shard* _shards;
+            unsigned int _nrOfShards;
+            size_t _shardCapacity;
+            unsigned int _resolution;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,121 @@
+#include "TimerWheel.h"
+
+using namespace Caelus::Utilities;
+
+namespace {
+    void link(TimerWheel::Node* head, TimerWheel::Node* node){
+        node->prev = head->prev;
+        node->next = head;
+        head->prev->next = node;
+        head->prev = node;
+    }
+
+    void unlink(TimerWheel::Node* node){
+        node->prev->next = node->next;
+        node->next->prev = node->prev;
+        node->prev = NULL;
+        node->next = NULL;
+    }
+}
+
+TimerWheel::TimerWheel(uint64_t now){
+    for (int l = 0; l < LEVELS; l++){
+        for (int s = 0; s < SLOTS; s++){
+            _slots[l][s].prev = &_slots[l][s];
+            _slots[l][s].next = &_slots[l][s];
+        }
+        _size[l] = 0;
+    }
+    _now = now;
+}
+
+void TimerWheel::schedule(Node* node, uint64_t expires){
+    cancel(node);
+    node->expires = expires;
+    //the current tick has already been expired, so the next one is the earliest
+    place(node, _now + 1);
+}
+
+void TimerWheel::cancel(Node* node){
+    if (!node->scheduled())
+        return;
+    unlink(node);
+    _size[node->level]--;
+}
+
+void TimerWheel::place(Node* node, uint64_t earliest){
+    uint64_t expires = node->expires;
+    if (expires < earliest){
+        //already due
+        expires = earliest;
+    }
+    uint64_t delta = expires - _now;
+    int level = 0;
+    while (level < LEVELS - 1 && delta >= ((uint64_t)1 << (BITS * (level + 1)))){
+        level++;
+    }
+    if (delta >= ((uint64_t)1 << (BITS * LEVELS))){
+        //too far away, park it in the furthest slot and place it again later
+        expires = _now + ((uint64_t)1 << (BITS * LEVELS)) - 1;
+    }
+    link(&_slots[level][(expires >> (BITS * level)) & (SLOTS - 1)], node);
+    node->level = level;
+    _size[level]++;
+}
+
+void TimerWheel::cascade(int level){
+    Node* head = &_slots[level][(_now >> (BITS * level)) & (SLOTS - 1)];
+    while (head->next != head){
+        Node* node = head->next;
+        unlink(node);
+        _size[level]--;
+        //the current slot is expired right after cascading
+        place(node, _now);
+    }
+}
+
+void TimerWheel::advance(uint64_t now, ExpireCallback expire, void* context){
+    while (_now < now){
+        if (size() == 0){
+            _now = now;
+            break;
+        }
+        if (_size[0] == 0){
+            //nothing can expire before the next cascade, skip ahead to it
+            uint64_t next = (_now | (SLOTS - 1)) + 1;
+            if (next > now){
+                _now = now;
+                break;
+            }
+            _now = next - 1;
+        }
+        _now++;
+
+        //move timers down from the higher levels, lowest level first so that
+        //nothing is placed in a slot that has already been cascaded this tick
+        for (int l = 1; l < LEVELS; l++){
+            if (_now & (((uint64_t)1 << (BITS * l)) - 1))
+                break;
+            cascade(l);
+        }
+
+        //expire everything in the current slot, detached first so that the
+        //callbacks can reschedule freely
+        Node* head = &_slots[0][_now & (SLOTS - 1)];
+        if (head->next == head)
+            continue;
+        Node due;
+        due.next = head->next;
+        due.prev = head->prev;
+        due.next->prev = &due;
+        due.prev->next = &due;
+        head->next = head;
+        head->prev = head;
+        while (due.next != &due){
+            Node* node = due.next;
+            unlink(node);
+            _size[0]--;
+            expire(node, context);
+        }
+    }
+}
@@ -0,0 +1,130 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2014 Alexander Nilsson
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef TIMERWHEEL_H_INCLUDED
+#define TIMERWHEEL_H_INCLUDED
+
+#include <cstdlib>
+#include <stdint.h>
+
+namespace Caelus {
+    namespace Utilities {
+
+        /**
+         * TimerWheel class, a hierarchical timing wheel with four levels of 64 slots.
+         * Timers are intrusive nodes, scheduling and cancelling is O(1) and advancing
+         * the wheel only touches the slots that are due, plus a cascade every 64 ticks.
+         * Ticks are an abstract unit chosen by the user. Timers further than 2^24 ticks
+         * away are parked in the last level and rescheduled as the wheel advances.
+         * This class is not thread safe, the owner is expected to lock it.
+         */
+        class TimerWheel {
+        public:
+            /**
+             * A timer, embed (or inherit) this in the object that is to expire.
+             */
+            struct Node {
+                Node() : prev(NULL), next(NULL), expires(0), level(0) {}
+                bool scheduled() const { return next != NULL; }
+
+                Node* prev;
+                Node* next;
+                uint64_t expires;
+                int level;
+            };
+
+            /**
+             * Called for every timer that expires. The node is already removed from
+             * the wheel and may be rescheduled or deleted by the callback.
+             */
+            typedef void (*ExpireCallback)(Node* node, void* context);
+
+        public:
+
+            /**
+             * Constructor:
+             * Creates an empty wheel
+             * @param now - the current tick
+             */
+            TimerWheel(uint64_t now = 0);
+
+            /**
+             * This schedules node to expire at tick expires. A node that is already
+             * scheduled is moved. Ticks that have already passed expire on the next
+             * call to advance().
+             * @param node - the timer
+             * @param expires - the tick at which it expires
+             */
+            void schedule(Node* node, uint64_t expires);
+
+            /**
+             * This removes node from the wheel, if it is scheduled
+             * @param node - the timer
+             */
+            void cancel(Node* node);
+
+            /**
+             * This advances the wheel to tick now, calling expire for every timer
+             * that expires at or before it.
+             * @param now - the current tick, ticks never move backwards
+             * @param expire - the function to call for each expired timer
+             * @param context - passed to expire as is
+             */
+            void advance(uint64_t now, ExpireCallback expire, void* context);
+
+            /**
+             * This returns the tick the wheel was last advanced to
+             * @return the current tick
+             */
+            uint64_t now() const {
+                return _now;
+            }
+
+            /**
+             * This returns the number of scheduled timers
+             * @return number of timers
+             */
+            size_t size() const {
+                return _size[0] + _size[1] + _size[2] + _size[3];
+            }
+
+        private:
+            enum { LEVELS = 4, BITS = 6, SLOTS = 1 << BITS };
+
+            void place(Node* node, uint64_t earliest);
+            void cascade(int level);
+
+            //never copied, the slots are linked to themselves
+            TimerWheel(const TimerWheel&);
+            TimerWheel& operator= (const TimerWheel&);
+
+        private:
+            //circular lists, the sentinels are the slot heads
+            Node _slots[LEVELS][SLOTS];
+            size_t _size[LEVELS];
+            uint64_t _now;
+        };
+    }
+}
+
+#endif
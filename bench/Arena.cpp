@@ -0,0 +1,106 @@
+//Measures the allocation latency of the SecretArena against the heap
+//(newDeleteResource(), which uses operator new), for single allocations and for
+//batches that keep many blocks alive, and the cost of constructing a string with
+//its memory taken from either. Linux only.
+//
+//Build and run from the repository root:
+//  g++ -std=c++11 -O2 -I. bench/Arena.cpp *.cpp -o arena_bench -lpthread
+//  ./arena_bench
+
+#include "Bench.h"
+
+#include <stdio.h>
+
+#ifdef __linux__
+#include "SecretArena.h"
+
+#include <string>
+#include <vector>
+
+using namespace Caelus::Utilities;
+
+namespace {
+    const size_t BATCH = 1000;
+
+    //allocates and releases one block at a time, the arena reuses it from its free list
+    double single(MemoryResource& resource, size_t size){
+        return Bench::nsPerOp([&]{
+            void* block = resource.allocate(size, 64);
+            Bench::doNotOptimize(block);
+            resource.deallocate(block, size, 64);
+        });
+    }
+
+    //allocates BATCH blocks before releasing them, so that the arena has to carve
+    //or map new memory, reported per block
+    double batch(MemoryResource& resource, size_t size){
+        std::vector<void*> blocks(BATCH);
+        return Bench::nsPerOp([&]{
+            for (size_t i = 0; i < BATCH; i++){
+                blocks[i] = resource.allocate(size, 64);
+            }
+            for (size_t i = 0; i < BATCH; i++){
+                resource.deallocate(blocks[i], size, 64);
+            }
+        }) / BATCH;
+    }
+
+    //constructs and destroys a string of size bytes, key and data included
+    double construct(MemoryResource& resource, size_t size){
+        std::string text(size, 'x');
+        SecureString::ssnr len = (SecureString::ssnr)size;
+        return Bench::nsPerOp([&]{
+            SecureString str(len, resource);
+            str.assign(text.c_str(), len);
+            Bench::doNotOptimize(&str);
+        });
+    }
+
+    void row(const char* name, size_t size, double heap, double arena){
+        printf("%-12s %8zu %12.1f %12.1f %8.2f\n", name, size, heap, arena, arena / heap);
+    }
+
+    const char* backingName(SecretArena::Backing backing){
+        switch (backing){
+        case SecretArena::SECRET:
+            return "memfd_secret";
+        case SecretArena::LOCKED:
+            return "mlock'ed anonymous memory";
+        default:
+            return "unlocked anonymous memory";
+        }
+    }
+}
+
+int main(){
+    MemoryResource& heap = *newDeleteResource();
+    SecretArena& arena = SecretArena::instance();
+    printf("SecretArena allocation latency, build mode %s\n", Bench::buildMode().c_str());
+    printf("the arena maps %s\n\n", backingName(arena.backing()));
+    printf("%-12s %8s %12s %12s %8s\n", "case", "bytes", "heap ns", "arena ns", "ratio");
+
+    size_t sizes[] = { 16, 64, 256, 4096, 16384, 65536 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++){
+        size_t size = sizes[s];
+        row("single", size, single(heap, size), single(arena, size));
+        row("batch", size, batch(heap, size), batch(arena, size));
+        row("string", size, construct(heap, size), construct(arena, size));
+        printf("\n");
+    }
+
+    SecretArena::Statistics stats = arena.statistics();
+    printf("ratio is arena time over heap time, lower is faster\n"
+           "batch keeps %zu blocks alive and reports the time per block\n"
+           "blocks over 4096 bytes get a mapping of their own from the arena\n\n", BATCH);
+    printf("arena mapped %llu bytes secret, %llu locked, %llu unlocked\n",
+           (unsigned long long)stats.mappedBytes[SecretArena::SECRET],
+           (unsigned long long)stats.mappedBytes[SecretArena::LOCKED],
+           (unsigned long long)stats.mappedBytes[SecretArena::UNLOCKED]);
+    return 0;
+}
+#else
+int main(){
+    printf("the SecretArena is only available on Linux\n");
+    return 0;
+}
+#endif
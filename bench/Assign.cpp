@@ -0,0 +1,81 @@
+//Measures the memory traffic of assign(). assign() writes the new content once and
+//only wipes the residual tail of the old content, where it used to wipe the whole
+//old content first and then write the new content over it. Both write patterns are
+//run on plain arrays for comparison, then the real assign() is timed.
+//
+//Build and run from the repository root:
+//  g++ -std=c++11 -O2 -I. bench/Assign.cpp *.cpp -o assign_bench -lpthread
+//  ./assign_bench
+
+#include "Bench.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace Caelus::Utilities;
+
+namespace {
+    struct Arrays {
+        std::vector<char> key, data, src;
+        Arrays(size_t size) : key(size + 1, 'k'), data(size + 1, 'd'), src(size + 1, 's') {}
+    };
+
+    //the old assign(): wipe the old content with the key, then write the new
+    //content over it, writes oldlen + 1 + len bytes
+    void wipeThenWrite(Arrays& a, size_t oldlen, size_t len){
+        memcpy(&a.data[0], &a.key[0], oldlen + 1);
+        for (size_t i = 0; i < len; i++){
+            a.data[i] = a.key[i] ^ a.src[i];
+        }
+        a.data[len] = a.key[len];
+    }
+
+    //the current assign(): write the new content, then wipe what is left of the
+    //old one, writes max(oldlen, len) + 1 bytes
+    void writeThenWipeTail(Arrays& a, size_t oldlen, size_t len){
+        for (size_t i = 0; i < len; i++){
+            a.data[i] = a.key[i] ^ a.src[i];
+        }
+        memcpy(&a.data[len], &a.key[len], std::max(oldlen, len) - len + 1);
+    }
+
+    void row(const char* name, size_t oldlen, size_t len, double ns, size_t written){
+        printf("%-22s %9zu %9zu %12.1f %12zu %10.2f\n", name, oldlen, len, ns, written, written / ns);
+    }
+}
+
+int main(){
+    printf("assign() memory traffic, build mode %s\n\n", Bench::buildMode().c_str());
+    printf("%-22s %9s %9s %12s %12s %10s\n", "case", "old len", "new len", "ns/op", "bytes/op", "GB/s");
+
+    size_t sizes[] = { 64, 1024, 64 * 1024, 1024 * 1024 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++){
+        size_t size = sizes[s];
+        //same length (rewriting a secret) and shrinking to a quarter
+        size_t cases[][2] = { { size, size }, { size, size / 4 } };
+        for (size_t c = 0; c < 2; c++){
+            size_t oldlen = cases[c][0], len = cases[c][1];
+            Arrays a(size);
+            double ns = Bench::nsPerOp([&]{ wipeThenWrite(a, oldlen, len); Bench::doNotOptimize(&a.data[0]); });
+            row("wipe then write", oldlen, len, ns, oldlen + 1 + len);
+            ns = Bench::nsPerOp([&]{ writeThenWipeTail(a, oldlen, len); Bench::doNotOptimize(&a.data[0]); });
+            row("write, wipe tail", oldlen, len, ns, std::max(oldlen, len) + 1);
+
+            std::string oldtext(oldlen, 'o'), newtext(len, 'n');
+            SecureString str;
+            str.allocate((SecureString::ssnr)size);
+            ns = Bench::nsPerOp([&]{
+                str.assign(oldtext.c_str(), (SecureString::ssnr)oldlen);
+                str.assign(newtext.c_str(), (SecureString::ssnr)len);
+            }) / 2;
+            row("SecureString::assign", oldlen, len, ns, std::max(oldlen, len) + 1);
+        }
+        printf("\n");
+    }
+    printf("bytes/op counts the bytes written to the data array, the SecureString rows\n"
+           "alternate between both lengths and report the average per assign()\n");
+    return 0;
+}
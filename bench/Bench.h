@@ -0,0 +1,200 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2014 Alexander Nilsson
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef BENCH_H_INCLUDED
+#define BENCH_H_INCLUDED
+
+#include "SecureString.h"
+
+#include <chrono>
+#include <stdint.h>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+//Helpers shared by the benchmark programs in this directory. The programs are
+//standalone, each one says at its top how to build and run it.
+namespace Bench {
+
+    /**
+     * Keeps the compiler from optimizing away the computation of a value that is
+     * otherwise unused.
+     */
+    inline void doNotOptimize(const void* p){
+#if defined(__GNUC__)
+        asm volatile("" : : "g"(p) : "memory");
+#else
+        static const void* volatile sink;
+        sink = p;
+#endif
+    }
+
+    /**
+     * Runs op in batches of growing size until the batches take at least
+     * minimum nanoseconds, and returns the time per call of the last batch.
+     * @param op - the operation, called with no arguments
+     * @param minimum - the shortest batch that is measured, in nanoseconds
+     * @return nanoseconds per call
+     */
+    template<class Op>
+    double nsPerOp(Op op, double minimum = 20e6){
+        for (uint64_t iterations = 1;; iterations *= 2){
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (uint64_t i = 0; i < iterations; i++){
+                op();
+            }
+            double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            if (ns >= minimum)
+                return ns / iterations;
+        }
+    }
+
+    /**
+     * This returns the SecureString build mode the program was compiled with,
+     * so that the results of several builds can be told apart.
+     * @return the compile time flags that change how strings are stored or locked
+     */
+    inline std::string buildMode(){
+        std::string mode;
+#ifdef SECURESTRING_THREADSAFE
+# if defined(SECURESTRING_STRIPED_LOCKS)
+        mode += "threadsafe(striped)";
+# elif defined(SECURESTRING_COMPACT_LOCK)
+        mode += "threadsafe(compact)";
+# else
+        mode += "threadsafe";
+# endif
+#endif
+#ifdef SECURESTRING_REGISTRY
+        mode += mode.empty() ? "registry" : "+registry";
+#endif
+#ifdef SECURESTRING_SECRET_STORAGE
+        mode += mode.empty() ? "secret-storage" : "+secret-storage";
+#endif
+#ifdef SECURESTRING_DEBUG
+        mode += mode.empty() ? "debug" : "+debug";
+#endif
+        return mode.empty() ? "default" : mode;
+    }
+
+#ifdef __linux__
+    /**
+     * PerfCounters class, the hardware counters of the calling thread read
+     * through perf_event. The counters only run between start() and stop() and
+     * add up over several runs. Opening them fails e.g. in containers or when
+     * /proc/sys/kernel/perf_event_paranoid is above 2, available() is then false
+     * and all counters read 0.
+     */
+    class PerfCounters {
+    public:
+        enum Counter { CYCLES, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, COUNT };
+
+        PerfCounters(){
+            static const uint64_t configs[COUNT] = {
+                PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+            };
+            _leader = -1;
+            for (int i = 0; i < COUNT; i++){
+                struct perf_event_attr attr;
+                memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = configs[i];
+                attr.disabled = i == 0;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_GROUP;
+                _fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, _leader, 0);
+                if (i == 0)
+                    _leader = _fds[0];
+            }
+            if (!available())
+                close();
+            else
+                ioctl(_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        }
+
+        ~PerfCounters(){
+            close();
+        }
+
+        bool available() const{
+            for (int i = 0; i < COUNT; i++){
+                if (_fds[i] < 0)
+                    return false;
+            }
+            return true;
+        }
+
+        void start(){
+            if (_leader >= 0)
+                ioctl(_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+
+        void stop(){
+            if (_leader >= 0)
+                ioctl(_leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        }
+
+        /**
+         * This returns the counts so far and resets them
+         * @param values - receives COUNT values, indexed by Counter
+         */
+        void read(uint64_t* values){
+            uint64_t group[1 + COUNT] = { 0 };
+            if (_leader < 0 || ::read(_leader, group, sizeof(group)) != (ssize_t)sizeof(group))
+                memset(group, 0, sizeof(group));
+            for (int i = 0; i < COUNT; i++){
+                values[i] = group[1 + i];
+            }
+            if (_leader >= 0)
+                ioctl(_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        }
+
+    private:
+        void close(){
+            for (int i = COUNT - 1; i >= 0; i--){
+                if (_fds[i] >= 0)
+                    ::close(_fds[i]);
+                _fds[i] = -1;
+            }
+            _leader = -1;
+        }
+
+        //never copied
+        PerfCounters(const PerfCounters&);
+        PerfCounters& operator= (const PerfCounters&);
+
+        int _fds[COUNT];
+        int _leader;
+    };
+#endif
+}
+
+#endif
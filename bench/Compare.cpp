@@ -0,0 +1,183 @@
+//Compares SecureString with std::string and with a reference implementation that
+//keeps the plaintext in an mlock'ed buffer. The same workloads run on all three,
+//the table shows the time per operation, the throughput relative to std::string
+//and the memory held per string. POSIX only.
+//
+//Build and run from the repository root, once per build mode to compare, e.g.:
+//  g++ -std=c++11 -O2 -I. bench/Compare.cpp *.cpp -o compare_bench -lpthread
+//  g++ -std=c++11 -O2 -DSECURESTRING_THREADSAFE -I. bench/Compare.cpp *.cpp -o compare_bench_threadsafe -lpthread
+//  g++ -std=c++11 -O2 -DSECURESTRING_THREADSAFE -DSECURESTRING_COMPACT_LOCK -I. bench/Compare.cpp *.cpp -o compare_bench_compact -lpthread
+//  g++ -std=c++11 -O2 -DSECURESTRING_SECRET_STORAGE -I. bench/Compare.cpp *.cpp -o compare_bench_secret -lpthread
+//  ./compare_bench; ./compare_bench_threadsafe; ./compare_bench_compact; ./compare_bench_secret
+
+#include "Bench.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+using namespace Caelus::Utilities;
+
+namespace {
+    /**
+     * The reference: the plaintext in a fixed size buffer that is mlock'ed, so it
+     * is never swapped out, and wiped when it is cleared or destroyed. It offers
+     * no protection against reading the memory, which is what SecureString adds.
+     */
+    class LockedBuffer {
+    public:
+        LockedBuffer(size_t capacity) : _length(0){
+            _mapped = (capacity + 1 + pageSize() - 1) / pageSize() * pageSize();
+            _data = (char*)mmap(NULL, _mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            _locked = mlock(_data, _mapped) == 0;
+            _data[0] = '\0';
+        }
+
+        ~LockedBuffer(){
+            SecureString::wipeMemory(_data, _length);
+            if (_locked)
+                munlock(_data, _mapped);
+            munmap(_data, _mapped);
+        }
+
+        void assign(const char* str, size_t len){
+            if (len < _length)
+                SecureString::wipeMemory(_data + len, _length - len);
+            memcpy(_data, str, len);
+            _data[len] = '\0';
+            _length = len;
+        }
+
+        void append(const char* str, size_t len){
+            memcpy(_data + _length, str, len);
+            _length += len;
+            _data[_length] = '\0';
+        }
+
+        void clear(){
+            SecureString::wipeMemory(_data, _length);
+            _length = 0;
+        }
+
+        size_t read(char* buffer) const{
+            memcpy(buffer, _data, _length + 1);
+            return _length;
+        }
+
+        bool equals(const char* str, size_t len) const{
+            return len == _length && memcmp(_data, str, len) == 0;
+        }
+
+        bool locked() const{
+            return _locked;
+        }
+
+        size_t footprint() const{
+            return sizeof(*this) + _mapped;
+        }
+
+    private:
+        static size_t pageSize(){
+            return (size_t)sysconf(_SC_PAGESIZE);
+        }
+
+        //never copied
+        LockedBuffer(const LockedBuffer&);
+        LockedBuffer& operator= (const LockedBuffer&);
+
+        char* _data;
+        size_t _length;
+        size_t _mapped;
+        bool _locked;
+    };
+
+    size_t footprint(const std::string& str){
+        //short strings are stored inside the object
+        const char* object = (const char*)&str;
+        bool inside = str.data() >= object && str.data() < object + sizeof(str);
+        return sizeof(str) + (inside ? 0 : str.capacity() + 1);
+    }
+
+    size_t footprint(const SecureString& str){
+        return str.memoryUsage().total;
+    }
+
+    void row(const char* op, size_t size, double stdNs, double secureNs, double lockedNs){
+        printf("%-14s %8zu %12.1f %12.1f %8.3f %12.1f %8.3f\n", op, size, stdNs, secureNs, stdNs / secureNs, lockedNs, stdNs / lockedNs);
+    }
+}
+
+int main(){
+    printf("SecureString compared to std::string and an mlock'ed buffer, build mode %s\n\n", Bench::buildMode().c_str());
+    printf("%-14s %8s %12s %12s %8s %12s %8s\n", "operation", "bytes", "std ns/op", "secure ns/op", "rel", "locked ns/op", "rel");
+
+    size_t sizes[] = { 16, 64, 256, 4096, 65536 };
+    const size_t count = sizeof(sizes) / sizeof(sizes[0]);
+    size_t footprints[count][3];
+    bool locked = true;
+    for (size_t s = 0; s < count; s++){
+        size_t size = sizes[s];
+        SecureString::ssnr len = (SecureString::ssnr)size;
+        std::string text(size, 'x');
+        const char* chars = text.c_str();
+        std::vector<char> buffer(size + 1);
+        bool ok = true;
+
+        double stdNs = Bench::nsPerOp([&]{ std::string str(chars, size); Bench::doNotOptimize(str.data()); });
+        double secureNs = Bench::nsPerOp([&]{ SecureString str(chars, len); Bench::doNotOptimize(&str); });
+        double lockedNs = Bench::nsPerOp([&]{ LockedBuffer str(size); str.assign(chars, size); Bench::doNotOptimize(&str); });
+        row("construct", size, stdNs, secureNs, lockedNs);
+
+        std::string stdStr(chars, size);
+        SecureString secureStr(chars, len);
+        LockedBuffer lockedStr(2 * size);
+        lockedStr.assign(chars, size);
+        locked = locked && lockedStr.locked();
+
+        stdNs = Bench::nsPerOp([&]{ stdStr.assign(chars, size); Bench::doNotOptimize(stdStr.data()); });
+        secureNs = Bench::nsPerOp([&]{ secureStr.assign(chars, len); });
+        lockedNs = Bench::nsPerOp([&]{ lockedStr.assign(chars, size); });
+        row("assign", size, stdNs, secureNs, lockedNs);
+
+        //each string is cleared and then appended to, so that it does not grow
+        stdNs = Bench::nsPerOp([&]{ stdStr.clear(); stdStr.append(chars, size); Bench::doNotOptimize(stdStr.data()); });
+        secureNs = Bench::nsPerOp([&]{ secureStr.assign(""); secureStr.append(chars, len); });
+        lockedNs = Bench::nsPerOp([&]{ lockedStr.clear(); lockedStr.append(chars, size); });
+        row("clear+append", size, stdNs, secureNs, lockedNs);
+
+        //a plaintext copy of the whole string
+        stdNs = Bench::nsPerOp([&]{ memcpy(&buffer[0], stdStr.c_str(), size + 1); Bench::doNotOptimize(&buffer[0]); });
+        secureNs = Bench::nsPerOp([&]{ Bench::doNotOptimize(secureStr.getUnsecureString()); secureStr.UnsecuredStringFinished(); });
+        lockedNs = Bench::nsPerOp([&]{ lockedStr.read(&buffer[0]); Bench::doNotOptimize(&buffer[0]); });
+        row("read", size, stdNs, secureNs, lockedNs);
+
+        stdNs = Bench::nsPerOp([&]{ ok = ok && stdStr.compare(0, std::string::npos, chars, size) == 0; });
+        secureNs = Bench::nsPerOp([&]{ ok = ok && secureStr.equals(chars); });
+        lockedNs = Bench::nsPerOp([&]{ ok = ok && lockedStr.equals(chars, size); });
+        row("equals", size, stdNs, secureNs, lockedNs);
+        if (!ok)
+            printf("equals() failed\n");
+        printf("\n");
+
+        std::string fitted(chars, size);
+        SecureString fittedSecure(chars, len);
+        LockedBuffer fittedLocked(size);
+        footprints[s][0] = footprint(fitted);
+        footprints[s][1] = footprint(fittedSecure);
+        footprints[s][2] = fittedLocked.footprint();
+    }
+
+    printf("rel is the throughput relative to std::string, higher is faster\n");
+    if (!locked)
+        printf("mlock failed (RLIMIT_MEMLOCK), the reference buffers are not locked\n");
+
+    printf("\nmemory held per string, in bytes, without allocator overhead\n");
+    printf("%8s %12s %12s %12s\n", "bytes", "std", "secure", "locked");
+    for (size_t s = 0; s < count; s++){
+        printf("%8zu %12zu %12zu %12zu\n", sizes[s], footprints[s][0], footprints[s][1], footprints[s][2]);
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+//Measures the cost of KeyringSecureString::read() with and without the in-process
+//cache, against copying a SecureString that is kept in memory. Without the cache
+//every read is a keyctl system call. Linux only.
+//
+//Build and run from the repository root:
+//  g++ -std=c++11 -O2 -I. bench/Keyring.cpp *.cpp -o keyring_bench -lpthread
+//  ./keyring_bench
+
+#include "Bench.h"
+
+#include <stdio.h>
+
+#ifdef __linux__
+#include "KeyringSecureString.h"
+
+#include <string>
+
+using namespace Caelus::Utilities;
+
+int main(){
+    printf("KeyringSecureString read cost, build mode %s\n\n", Bench::buildMode().c_str());
+
+    //the payload of a user key is limited to 32767 bytes
+    size_t sizes[] = { 16, 256, 4096, 32767 };
+    bool header = false;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++){
+        size_t size = sizes[s];
+        SecureString secret(std::string(size, 'k').c_str());
+        KeyringSecureString uncached(secret, "securestring-bench:uncached", 0);
+        //long enough not to expire while it is measured
+        KeyringSecureString cached(secret, "securestring-bench:cached", 60000);
+        if (!uncached.valid() || !cached.valid()){
+            printf("the kernel keyring is not available, add_key failed\n");
+            return 0;
+        }
+        if (!header){
+            printf("%-20s %8s %12s %12s\n", "case", "bytes", "ns/read", "vs memory");
+            header = true;
+        }
+
+        SecureString value;
+        bool ok = true;
+        double memory = Bench::nsPerOp([&]{ value.assign(secret); });
+        double hit = Bench::nsPerOp([&]{ ok = cached.read(value) && ok; });
+        double miss = Bench::nsPerOp([&]{ ok = uncached.read(value) && ok; });
+        //each read goes to the kernel and then fills the cache again
+        double refill = Bench::nsPerOp([&]{ cached.invalidateCache(); ok = cached.read(value) && ok; });
+        if (!ok || !value.equals(secret))
+            printf("read() failed\n");
+
+        printf("%-20s %8zu %12.1f %12.2f\n", "SecureString copy", size, memory, 1.0);
+        printf("%-20s %8zu %12.1f %12.2f\n", "cached read", size, hit, hit / memory);
+        printf("%-20s %8zu %12.1f %12.2f\n", "uncached read", size, miss, miss / memory);
+        printf("%-20s %8zu %12.1f %12.2f\n", "read and refill", size, refill, refill / memory);
+        printf("\n");
+    }
+    printf("vs memory is the time relative to copying a SecureString in memory\n");
+    return 0;
+}
+#else
+int main(){
+    printf("the kernel keyring is only available on Linux\n");
+    return 0;
+}
+#endif
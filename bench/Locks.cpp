@@ -0,0 +1,115 @@
+//Shows the trade-off between a lock in every string and the striped lock table of
+//the thread safe build: the size of a string, the cost of constructing one, and
+//the throughput of locked operations on one thread and on several threads, each
+//working on strings of its own or all on the same string.
+//
+//Build and run from the repository root, once per locking mode:
+//  g++ -std=c++11 -O2 -DSECURESTRING_THREADSAFE -I. bench/Locks.cpp *.cpp -o locks_bench_mutex -lpthread
+//  g++ -std=c++11 -O2 -DSECURESTRING_THREADSAFE -DSECURESTRING_COMPACT_LOCK -I. bench/Locks.cpp *.cpp -o locks_bench_compact -lpthread
+//  g++ -std=c++11 -O2 -DSECURESTRING_THREADSAFE -DSECURESTRING_STRIPED_LOCKS -I. bench/Locks.cpp *.cpp -o locks_bench_striped -lpthread
+//  ./locks_bench_mutex; ./locks_bench_compact; ./locks_bench_striped
+//Without SECURESTRING_THREADSAFE the numbers are the unlocked baseline.
+
+#include "Bench.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace Caelus::Utilities;
+
+namespace {
+    const char* TEXT = "0123456789abcdef";
+    const SecureString::ssnr LEN = 16;
+    //locked operations per thread in the threaded runs
+    const int OPS = 200000;
+
+    //one locked write and one locked read
+    bool work(SecureString& str){
+        str.assign(TEXT, LEN);
+        return str.equals(TEXT);
+    }
+
+    //runs threads threads, thread t works on strings[t % strings.size()] and
+    //cycles through perThread of them, returns the operations per microsecond
+    double threaded(unsigned int threads, std::vector<SecureString*>& strings, size_t perThread){
+        std::atomic<unsigned int> ready(0);
+        std::atomic<bool> go(false);
+        std::atomic<bool> ok(true);
+        std::vector<std::thread> workers;
+        for (unsigned int t = 0; t < threads; t++){
+            workers.push_back(std::thread([&, t]{
+                size_t first = (t * perThread) % strings.size();
+                ready.fetch_add(1);
+                while (!go.load()){
+                }
+                bool equal = true;
+                for (int i = 0; i < OPS; i++){
+                    equal = work(*strings[first + i % perThread]) && equal;
+                }
+                if (!equal)
+                    ok.store(false);
+            }));
+        }
+        while (ready.load() < threads){
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        go.store(true);
+        for (size_t t = 0; t < workers.size(); t++){
+            workers[t].join();
+        }
+        double us = (double)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        if (!ok.load())
+            printf("equals() failed\n");
+        return (double)threads * OPS / us;
+    }
+}
+
+int main(){
+    printf("SecureString locking, build mode %s\n", Bench::buildMode().c_str());
+#if defined(SECURESTRING_THREADSAFE) && defined(SECURESTRING_STRIPED_LOCKS)
+    printf("%d lock stripes\n", SECURESTRING_LOCK_STRIPES);
+#endif
+    SecureString sample(TEXT);
+    printf("\n%-32s %8zu bytes\n", "sizeof(SecureString)", sizeof(SecureString));
+    printf("%-32s %8zu bytes\n", "memory of a 16 byte string", sample.memoryUsage().total);
+
+    double ns = Bench::nsPerOp([&]{ SecureString str; Bench::doNotOptimize(&str); });
+    printf("%-32s %8.1f ns\n", "construct and destroy, empty", ns);
+    ns = Bench::nsPerOp([&]{ SecureString str(TEXT); Bench::doNotOptimize(&str); });
+    printf("%-32s %8.1f ns\n", "construct and destroy, 16 bytes", ns);
+    ns = Bench::nsPerOp([&]{ Bench::doNotOptimize(&sample); sample.length(); });
+    printf("%-32s %8.1f ns\n", "length(), uncontended", ns);
+    bool equal = true;
+    ns = Bench::nsPerOp([&]{ equal = work(sample) && equal; });
+    printf("%-32s %8.1f ns\n", "assign()+equals(), uncontended", ns);
+    if (!equal)
+        printf("equals() failed\n");
+
+    unsigned int cores = std::max(2u, std::thread::hardware_concurrency());
+    const size_t PER_THREAD = 64;
+    std::vector<SecureString*> strings;
+    for (size_t i = 0; i < cores * PER_THREAD; i++){
+        strings.push_back(new SecureString(TEXT));
+    }
+    std::vector<SecureString*> shared(1, strings[0]);
+
+    printf("\nassign()+equals() pairs per microsecond, all threads together\n");
+    printf("%8s %14s %14s %14s\n", "threads", "own string", "own 64 strings", "one shared");
+    for (unsigned int threads = 1; threads <= cores; threads *= 2){
+        double own = threaded(threads, strings, 1);
+        double many = threaded(threads, strings, PER_THREAD);
+        double one = threaded(threads, shared, 1);
+        printf("%8u %14.2f %14.2f %14.2f\n", threads, own, many, one);
+    }
+    printf("\nwith striped locks, unrelated strings that map to the same stripe\n"
+           "contend, which shows in the own string columns\n");
+
+    for (size_t i = 0; i < strings.size(); i++){
+        delete strings[i];
+    }
+    return 0;
+}
@@ -0,0 +1,120 @@
+//Reads the hardware counters (cycles, instructions, cache misses and branch
+//misses) around the byte loops of SecureString, and reports the instructions per
+//cycle and the misses per KB of string processed for assign(), append(),
+//getUnsecureString() and equals(). Linux only.
+//
+//Build and run from the repository root (add the flags of the build mode to measure):
+//  g++ -std=c++11 -O2 -I. bench/Perf.cpp *.cpp -o perf_bench -lpthread
+//  ./perf_bench
+//The counters need /proc/sys/kernel/perf_event_paranoid at 2 or lower, without
+//them only the time per operation is reported.
+
+#include "Bench.h"
+
+#include <stdio.h>
+
+#ifdef __linux__
+#include <algorithm>
+#include <string>
+
+using namespace Caelus::Utilities;
+
+namespace {
+    struct Result {
+        double ns;     //per operation
+        double ipc;
+        double cacheMissesPerKB;
+        double branchMissesPerKB;
+        double cyclesPerByte;
+    };
+
+    /**
+     * Runs op in batches of batch calls, with reset called between the batches
+     * outside of the measurement, until the batches took at least 50 ms.
+     */
+    template<class Op, class Reset>
+    Result measure(Bench::PerfCounters& counters, size_t bytesPerOp, size_t batch, Op op, Reset reset){
+        uint64_t values[Bench::PerfCounters::COUNT];
+        counters.read(values);
+        double ns = 0;
+        uint64_t ops = 0;
+        while (ns < 50e6){
+            reset();
+            counters.start();
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < batch; i++){
+                op();
+            }
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            counters.stop();
+            ns += (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+            ops += batch;
+        }
+        counters.read(values);
+
+        double kb = (double)ops * bytesPerOp / 1024;
+        Result result;
+        result.ns = ns / ops;
+        result.ipc = values[Bench::PerfCounters::CYCLES] ? (double)values[Bench::PerfCounters::INSTRUCTIONS] / values[Bench::PerfCounters::CYCLES] : 0;
+        result.cacheMissesPerKB = values[Bench::PerfCounters::CACHE_MISSES] / kb;
+        result.branchMissesPerKB = values[Bench::PerfCounters::BRANCH_MISSES] / kb;
+        result.cyclesPerByte = values[Bench::PerfCounters::CYCLES] / (kb * 1024);
+        return result;
+    }
+
+    void row(const char* name, size_t size, const Result& r, bool counted){
+        if (counted)
+            printf("%-22s %8zu %12.1f %8.2f %14.3f %15.3f %12.2f\n", name, size, r.ns, r.ipc, r.cacheMissesPerKB, r.branchMissesPerKB, r.cyclesPerByte);
+        else
+            printf("%-22s %8zu %12.1f %8s %14s %15s %12s\n", name, size, r.ns, "n/a", "n/a", "n/a", "n/a");
+    }
+}
+
+int main(){
+    Bench::PerfCounters counters;
+    bool counted = counters.available();
+    printf("SecureString hardware counters, build mode %s\n", Bench::buildMode().c_str());
+    if (!counted)
+        printf("perf_event is not available, only the time is reported\n");
+    printf("\n%-22s %8s %12s %8s %14s %15s %12s\n", "operation", "bytes", "ns/op", "IPC", "cache miss/KB", "branch miss/KB", "cycles/byte");
+
+    size_t sizes[] = { 16, 256, 4096, 65536 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++){
+        size_t size = sizes[s];
+        SecureString::ssnr len = (SecureString::ssnr)size;
+        std::string text(size, 'x');
+        const char* chars = text.c_str();
+        //enough calls per batch to process about 1 MiB
+        size_t batch = std::max((size_t)1, (size_t)(1024 * 1024) / size);
+
+        SecureString str;
+        str.allocate(len);
+        row("assign", size, measure(counters, size, batch, [&]{ str.assign(chars, len); }, []{}), counted);
+
+        //the string is emptied between the batches, so that it never grows
+        SecureString appended;
+        appended.allocate((SecureString::ssnr)(batch * size));
+        row("append", size, measure(counters, size, batch, [&]{ appended.append(chars, len); },
+                                    [&]{ appended.assign(""); }), counted);
+
+        row("getUnsecureString", size, measure(counters, size, batch, [&]{
+            Bench::doNotOptimize(str.getUnsecureString());
+            str.UnsecuredStringFinished();
+        }, []{}), counted);
+
+        bool equal = true;
+        row("equals(const char*)", size, measure(counters, size, batch, [&]{ equal = equal && str.equals(chars); }, []{}), counted);
+        SecureString other(str);
+        row("equals(SecureString)", size, measure(counters, size, batch, [&]{ equal = equal && str.equals(other); }, []{}), counted);
+        if (!equal)
+            printf("equals() failed\n");
+        printf("\n");
+    }
+    return 0;
+}
+#else
+int main(){
+    printf("perf_event is only available on Linux\n");
+    return 0;
+}
+#endif
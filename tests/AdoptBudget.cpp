@@ -0,0 +1,79 @@
+//Checks that adopt() never leaks the plaintext of a buffer it has taken over,
+//also when the memory budget does not leave room for its key.
+//
+//Build and run from the repository root:
+//  g++ -std=c++11 -I. tests/AdoptBudget.cpp *.cpp -o adopt_budget -lpthread
+//  ./adopt_budget
+
+#include "SecureString.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <new>
+
+using namespace Caelus::Utilities;
+
+namespace {
+    int failures = 0;
+    int released = 0;
+    bool wiped = false;
+
+    void check(bool condition, const char* what){
+        if (!condition){
+            fprintf(stderr, "FAILED: %s\n", what);
+            failures++;
+        }
+    }
+
+    //records that the buffer was zeroed before it was released
+    void deleter(SecureString::ssarr buf, SecureString::ssnr size){
+        wiped = true;
+        for (SecureString::ssnr i = 0; i < size; i++){
+            wiped = wiped && buf[i] == 0;
+        }
+        released++;
+        delete[] buf;
+    }
+
+    SecureString::ssarr plaintext(SecureString::ssnr len){
+        SecureString::ssarr buf = new SecureString::ssbyte[len + 1];
+        memset(buf, 'x', len);
+        buf[len] = '\0';
+        return buf;
+    }
+}
+
+int main(){
+    const SecureString::ssnr LEN = 1000;
+
+    //within the budget the buffer is kept until the string is done with it
+    {
+        SecureString str;
+        str.adopt(plaintext(LEN), LEN, deleter);
+        check(str.length() == LEN && str.verify(), "adopted string");
+        check(released == 0, "buffer kept while in use");
+    }
+    check(released == 1 && wiped, "buffer wiped and released by the destructor");
+
+    //over the budget adopt() throws, and the buffer is wiped and released all the same
+    released = 0;
+    wiped = false;
+    {
+        SecureString str("unchanged");
+        SecureString::setMemoryBudget(SecureString::statistics().storageBytes + 1);
+        bool thrown = false;
+        try {
+            str.adopt(plaintext(LEN), LEN, deleter);
+        } catch (const std::bad_alloc&) {
+            thrown = true;
+        }
+        SecureString::setMemoryBudget(0);
+        check(thrown, "adopt() over the budget throws std::bad_alloc");
+        check(released == 1 && wiped, "buffer wiped and released when adopt() throws");
+        check(str.equals("unchanged") && str.verify(), "string unchanged when adopt() throws");
+    }
+
+    if (failures == 0)
+        printf("adopt budget OK\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+//Checks that the hot paths of SecureString stay within their allocation budget.
+//Every heap allocation of the process is counted by replacing operator new, and
+//compared to the SecureString::statistics() counters, a path that allocates more
+//than its budget fails the test. Before C++17 the over-aligned string storage is
+//allocated with posix_memalign, which only the statistics count.
+//
+//Build and run from the repository root:
+//  g++ -std=c++11 -I. tests/AllocationBudget.cpp *.cpp -o allocation_budget -lpthread
+//  ./allocation_budget
+//and again with -std=c++17 to count the aligned operator new as well.
+
+#include "SecureString.h"
+#include "FrozenSecureString.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace Caelus::Utilities;
+
+namespace {
+    std::atomic<uint64_t> newCount(0);
+    int failures = 0;
+    //the string length being checked, reported with failures
+    size_t checkedSize = 0;
+
+    void* countedNew(size_t size){
+        newCount.fetch_add(1, std::memory_order_relaxed);
+        void* p = malloc(size ? size : 1);
+        if (p == NULL)
+            throw std::bad_alloc();
+        return p;
+    }
+
+    void check(const char* expr, uint64_t budget, uint64_t news, uint64_t blocks, int line){
+        if (news > budget || blocks > budget){
+            fprintf(stderr, "line %d (size %zu): %s allocated %llu heap blocks (%llu through SecureString), the budget is %llu\n",
+                    line, checkedSize, expr, (unsigned long long)news, (unsigned long long)blocks, (unsigned long long)budget);
+            failures++;
+        }
+    }
+}
+
+void* operator new(size_t size){
+    return countedNew(size);
+}
+
+void* operator new[](size_t size){
+    return countedNew(size);
+}
+
+void operator delete(void* p) noexcept{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept{
+    free(p);
+}
+
+#ifdef __cpp_aligned_new
+void* operator new(size_t size, std::align_val_t alignment){
+    newCount.fetch_add(1, std::memory_order_relaxed);
+    void* p;
+    if (posix_memalign(&p, (size_t)alignment, size ? size : 1) != 0)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p, std::align_val_t) noexcept{
+    free(p);
+}
+#endif
+
+//runs expr and fails when it allocates more than budget heap blocks
+#define EXPECT_ALLOCATIONS(budget, expr) do { \
+        uint64_t news = newCount.load(); \
+        uint64_t blocks = SecureString::statistics().allocations; \
+        expr; \
+        check(#expr, budget, newCount.load() - news, SecureString::statistics().allocations - blocks, __LINE__); \
+    } while (0)
+
+//the growth paths of a string of size characters
+void checkSize(size_t size){
+    typedef SecureString::ssnr ssnr;
+    checkedSize = size;
+    std::string text(size, 'x');
+    const char* chars = text.c_str();
+    ssnr len = (ssnr)size;
+
+    //a string that fits its capacity is written in place, growing reallocates
+    //the key and data arrays once
+    {
+        SecureString str;
+        EXPECT_ALLOCATIONS(2, str.allocate(len));
+        EXPECT_ALLOCATIONS(0, str.assign(chars, len));
+        EXPECT_ALLOCATIONS(0, str.assign("x"));
+        EXPECT_ALLOCATIONS(0, str.append(chars + 1, len - 1));
+        EXPECT_ALLOCATIONS(2, str.append("grow"));
+        EXPECT_ALLOCATIONS(0, str.assign(chars, len));
+        EXPECT_ALLOCATIONS(0, str.equals(chars));
+        EXPECT_ALLOCATIONS(0, str.verify());
+        EXPECT_ALLOCATIONS(1, str.getUnsecureString());
+        EXPECT_ALLOCATIONS(0, str.UnsecuredStringFinished());
+    }
+    {
+        SecureString str;
+        EXPECT_ALLOCATIONS(2, str.assign(chars, len));
+        SecureString copy;
+        EXPECT_ALLOCATIONS(2, copy.assign(str));
+        EXPECT_ALLOCATIONS(2, SecureString s(str));
+        EXPECT_ALLOCATIONS(0, str.equals(copy));
+        EXPECT_ALLOCATIONS(2, str.append(copy));
+    }
+
+    //adopt() only allocates the key, the buffer becomes the data array, very
+    //short strings are copied instead
+    {
+        SecureString str;
+        SecureString::ssarr buf = new SecureString::ssbyte[len + 1];
+        memcpy(buf, chars, len + 1);
+        EXPECT_ALLOCATIONS(size < sizeof(ssnr) ? 2 : 1, str.adopt(buf, len));
+    }
+
+    //the std::string and std::vector sinks copy into new arrays once
+    {
+        std::string source(text);
+        EXPECT_ALLOCATIONS(2, SecureString s(std::move(source)));
+        std::vector<char> vector(text.begin(), text.end());
+        EXPECT_ALLOCATIONS(2, SecureString s(std::move(vector)));
+        SecureString str;
+        std::string grow(text);
+        EXPECT_ALLOCATIONS(2, str.assign(std::move(grow)));
+        std::string fits(text);
+        EXPECT_ALLOCATIONS(0, str.assign(std::move(fits)));
+    }
+    checkedSize = 0;
+}
+
+int main(){
+    //the first string sets up the per-thread key generator
+    { SecureString warmup("warmup"); }
+
+    //both sides of the size class boundaries, and large strings
+    size_t sizes[] = { 1, 3, 4, 62, 63, 64, 65, 127, 128, 1000, 65535, 65536, 1000000 };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++){
+        checkSize(sizes[i]);
+    }
+
+    SecureString::ssbyte buffer[64];
+    SecureString str;
+    bool result = false;
+
+    EXPECT_ALLOCATIONS(2, SecureString s("secret"));
+    EXPECT_ALLOCATIONS(2, SecureString s(str));
+    EXPECT_ALLOCATIONS(2, str.assign("password"));
+    EXPECT_ALLOCATIONS(0, str.assign("short"));
+    EXPECT_ALLOCATIONS(0, str.append("er"));
+    EXPECT_ALLOCATIONS(0, result = str.at(0) == 's');
+    EXPECT_ALLOCATIONS(0, result = str.length() == 7);
+    EXPECT_ALLOCATIONS(0, result = str.equals("shorter"));
+    EXPECT_ALLOCATIONS(0, result = str.equals(str));
+    EXPECT_ALLOCATIONS(0, result = str.verify());
+    EXPECT_ALLOCATIONS(1, str.getUnsecureString());
+    EXPECT_ALLOCATIONS(0, str.UnsecuredStringFinished());
+    EXPECT_ALLOCATIONS(2, str.allocate(1024));
+
+    FrozenSecureString frozen(str);
+    EXPECT_ALLOCATIONS(1, FrozenSecureString f(str));
+    EXPECT_ALLOCATIONS(0, frozen.getUnsecureString(buffer, sizeof(buffer)));
+    (void)result;
+
+    if (failures == 0)
+        printf("allocation budgets OK\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+//Checks that SecureStringCache::put() leaves the cache consistent when copying
+//the value throws, here because the memory budget is exhausted.
+//
+//Build and run from the repository root:
+//  g++ -std=c++11 -I. tests/CacheBudget.cpp *.cpp -o cache_budget -lpthread
+//  ./cache_budget
+
+#include "SecureString.h"
+#include "SecureStringCache.h"
+
+#include <stdio.h>
+#include <new>
+#include <string>
+
+using namespace Caelus::Utilities;
+
+namespace {
+    int failures = 0;
+
+    void check(bool condition, const char* what){
+        if (!condition){
+            fprintf(stderr, "FAILED: %s\n", what);
+            failures++;
+        }
+    }
+
+    //puts value while the budget leaves no room for a copy of it
+    bool putOverBudget(SecureStringCache& cache, const std::string& name, const SecureString& value){
+        SecureString::setMemoryBudget(SecureString::statistics().storageBytes + 1);
+        bool thrown = false;
+        try {
+            cache.put(name, value, 60000);
+        } catch (const std::bad_alloc&) {
+            thrown = true;
+        }
+        SecureString::setMemoryBudget(0);
+        return thrown;
+    }
+}
+
+int main(){
+    SecureString large(std::string(100000, 'x').c_str());
+    SecureString value;
+    uint64_t objects = SecureString::statistics().objects;
+    {
+        SecureStringCache cache(2, 1);
+
+        //a new entry that cannot be filled in is not added
+        check(putOverBudget(cache, "a", large), "put() over the budget throws std::bad_alloc");
+        check(cache.size() == 0, "no entry left behind");
+        check(!cache.get("a", value), "get() finds nothing");
+        check(!cache.erase("a"), "erase() finds nothing");
+        check(SecureString::statistics().objects == objects, "the entry is destroyed");
+
+        //the cache works normally afterwards
+        cache.put("a", SecureString("first"), 60000);
+        cache.put("b", SecureString("second"), 60000);
+        check(cache.get("a", value) && value.equals("first"), "put() after a failed put()");
+
+        //an existing entry that cannot be replaced keeps its value
+        check(putOverBudget(cache, "a", large), "replacing over the budget throws std::bad_alloc");
+        check(cache.get("a", value) && value.equals("first"), "entry keeps its value");
+
+        //a full cache does not evict for a new entry that cannot be filled in
+        check(putOverBudget(cache, "c", large), "put() into a full cache over the budget throws");
+        check(cache.size() == 2 && cache.get("b", value) && value.equals("second"), "nothing evicted");
+
+        //eviction still follows the least recently used order
+        cache.get("a", value);
+        cache.put("c", SecureString("third"), 60000);
+        check(cache.size() == 2 && !cache.get("b", value), "least recently used entry evicted");
+        check(cache.get("a", value) && cache.get("c", value) && value.equals("third"), "other entries kept");
+
+        check(cache.erase("a"), "erase() an entry");
+        cache.clear();
+        check(cache.size() == 0, "clear()");
+    }
+    check(SecureString::statistics().objects == objects, "all entries destroyed");
+
+    if (failures == 0)
+        printf("cache budget OK\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+//Checks FrozenSecureString::send() and receive() between two processes over a
+//socketpair, and that receive() rejects descriptors whose contents the sender
+//could still change, without leaking them. Linux only.
+//
+//Build and run from the repository root:
+//  g++ -std=c++11 -I. tests/FrozenShare.cpp *.cpp -o frozen_share -lpthread
+//  ./frozen_share
+
+#include "SecureString.h"
+#include "FrozenSecureString.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace Caelus::Utilities;
+
+namespace {
+    int failures = 0;
+
+    void check(bool condition, const char* what){
+        if (!condition){
+            fprintf(stderr, "FAILED: %s\n", what);
+            failures++;
+        }
+    }
+
+    int openDescriptors(){
+        int count = 0;
+        DIR* dir = opendir("/proc/self/fd");
+        while (readdir(dir) != NULL)
+            count++;
+        closedir(dir);
+        return count;
+    }
+
+    //sends one byte with the descriptors attached, like send() does
+    bool sendDescriptors(int socket, const int* fds, int count){
+        char payload = 0;
+        struct iovec iov;
+        iov.iov_base = &payload;
+        iov.iov_len = 1;
+        union {
+            char buffer[CMSG_SPACE(2 * sizeof(int))];
+            struct cmsghdr align;
+        } control;
+        memset(&control, 0, sizeof(control));
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buffer;
+        msg.msg_controllen = CMSG_SPACE(count * sizeof(int));
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(count * sizeof(int));
+        memcpy(CMSG_DATA(cmsg), fds, count * sizeof(int));
+        return sendmsg(socket, &msg, MSG_NOSIGNAL) == 1;
+    }
+
+    //the memfd that send() passes, taken off the socket without receive()
+    int sentDescriptor(const FrozenSecureString& frozen){
+        int sockets[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0)
+            return -1;
+        int fd = -1;
+        if (frozen.send(sockets[0])){
+            char payload;
+            struct iovec iov;
+            iov.iov_base = &payload;
+            iov.iov_len = 1;
+            union {
+                char buffer[CMSG_SPACE(sizeof(int))];
+                struct cmsghdr align;
+            } control;
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = control.buffer;
+            msg.msg_controllen = sizeof(control.buffer);
+            if (recvmsg(sockets[1], &msg, MSG_CMSG_CLOEXEC) == 1 && CMSG_FIRSTHDR(&msg) != NULL)
+                memcpy(&fd, CMSG_DATA(CMSG_FIRSTHDR(&msg)), sizeof(int));
+        }
+        close(sockets[0]);
+        close(sockets[1]);
+        return fd;
+    }
+
+    //copies the contents of src into dst
+    bool copyContents(int src, int dst){
+        char buffer[4096];
+        off_t size = lseek(src, 0, SEEK_END);
+        for (off_t offset = 0; offset < size;){
+            ssize_t n = pread(src, buffer, sizeof(buffer), offset);
+            if (n <= 0 || pwrite(dst, buffer, n, offset) != n)
+                return false;
+            offset += n;
+        }
+        return true;
+    }
+
+    //sends the descriptors to a FrozenSecureString, true when it accepts them,
+    //leaked reports whether any of them is left open in the receiver
+    bool received(FrozenSecureString& frozen, const int* fds, int count, bool& leaked){
+        int sockets[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0)
+            return false;
+        bool sent = sendDescriptors(sockets[0], fds, count);
+        int before = openDescriptors();
+        bool ok = sent && frozen.receive(sockets[1]);
+        leaked = openDescriptors() != before;
+        close(sockets[0]);
+        close(sockets[1]);
+        return ok;
+    }
+}
+
+int main(){
+    FrozenSecureString secret(SecureString("hunter2"));
+
+    //the sender and the receiver are separate processes
+    {
+        int sockets[2];
+        check(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == 0, "socketpair");
+        pid_t pid = fork();
+        if (pid == 0){
+            close(sockets[1]);
+            bool ok = secret.send(sockets[0]);
+            close(sockets[0]);
+            _exit(ok ? 0 : 1);
+        }
+        close(sockets[0]);
+        FrozenSecureString frozen(SecureString("other"));
+        check(frozen.receive(sockets[1]), "receive from another process");
+        check(frozen.equals("hunter2") && frozen.equals(secret), "received contents");
+        close(sockets[1]);
+        int status = 0;
+        waitpid(pid, &status, 0);
+        check(WIFEXITED(status) && WEXITSTATUS(status) == 0, "send in another process");
+    }
+
+    int sealed = sentDescriptor(secret);
+    check(sealed >= 0, "send() passes a memfd");
+    bool leaked = false;
+
+    //the sealed memfd itself is accepted
+    {
+        FrozenSecureString frozen(SecureString("other"));
+        check(received(frozen, &sealed, 1, leaked) && frozen.equals("hunter2"), "sealed memfd is accepted");
+    }
+
+    //a regular file with the same contents is not, the sender could still write to it
+    {
+        char path[] = "/tmp/frozen_share_XXXXXX";
+        int file = mkstemp(path);
+        unlink(path);
+        check(copyContents(sealed, file), "copy to a regular file");
+        FrozenSecureString frozen(SecureString("other"));
+        check(!received(frozen, &file, 1, leaked) && !leaked, "regular file is rejected and closed");
+        check(frozen.equals("other"), "contents unchanged after a rejected file");
+        close(file);
+    }
+
+    //neither is a memfd that is missing any of the seals
+    int missing[] = { 0, F_SEAL_WRITE, F_SEAL_SHRINK, F_SEAL_GROW, F_SEAL_SEAL };
+    for (size_t i = 0; i < sizeof(missing) / sizeof(missing[0]); i++){
+        int memfd = memfd_create("frozen_share", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        check(copyContents(sealed, memfd), "copy to a memfd");
+        int seals = (F_SEAL_WRITE | F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) & ~missing[i];
+        if (i > 0)
+            fcntl(memfd, F_ADD_SEALS, seals);
+        FrozenSecureString frozen(SecureString("other"));
+        check(!received(frozen, &memfd, 1, leaked) && !leaked, "memfd with a missing seal is rejected and closed");
+        close(memfd);
+    }
+
+    //and neither are several descriptors at once
+    {
+        int fds[] = { sealed, sealed };
+        FrozenSecureString frozen(SecureString("other"));
+        check(!received(frozen, fds, 2, leaked) && !leaked, "several descriptors are rejected and closed");
+    }
+
+    close(sealed);
+    if (failures == 0)
+        printf("frozen share OK\n");
+    return failures == 0 ? 0 : 1;
+}
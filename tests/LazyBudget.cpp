@@ -0,0 +1,77 @@
+//Checks that LazySecureString does not leak the string it loads into, nor the
+//file it reads, when loading throws because the memory budget is exhausted.
+//Linux only.
+//
+//Build and run from the repository root:
+//  g++ -std=c++11 -I. tests/LazyBudget.cpp *.cpp -o lazy_budget -lpthread
+//  ./lazy_budget
+
+#include "SecureString.h"
+#include "LazySecureString.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <new>
+#include <string>
+
+using namespace Caelus::Utilities;
+
+namespace {
+    int failures = 0;
+
+    void check(bool condition, const char* what){
+        if (!condition){
+            fprintf(stderr, "FAILED: %s\n", what);
+            failures++;
+        }
+    }
+
+    int openDescriptors(){
+        int count = 0;
+        DIR* dir = opendir("/proc/self/fd");
+        while (readdir(dir) != NULL)
+            count++;
+        closedir(dir);
+        return count;
+    }
+}
+
+int main(){
+    const size_t LEN = 200000;
+    char path[] = "/tmp/lazy_budget_XXXXXX";
+    int fd = mkstemp(path);
+    std::string contents(LEN, 's');
+    check(write(fd, contents.data(), LEN) == (ssize_t)LEN, "write the secret file");
+    close(fd);
+
+    uint64_t objects = SecureString::statistics().objects;
+    int descriptors = openDescriptors();
+    {
+        LazySecureString lazy(path);
+
+        //the budget runs out while the file is being read
+        SecureString::setMemoryBudget(SecureString::statistics().storageBytes + 10000);
+        bool thrown = false;
+        try {
+            lazy.get();
+        } catch (const std::bad_alloc&) {
+            thrown = true;
+        }
+        SecureString::setMemoryBudget(0);
+        check(thrown, "loading over the budget throws std::bad_alloc");
+        check(!lazy.loaded() && !lazy.failed(), "not loaded after the exception");
+        check(SecureString::statistics().objects == objects, "partially loaded string destroyed");
+        check(openDescriptors() == descriptors, "file closed");
+
+        //the next access loads the secret
+        check(lazy.get().length() == (SecureString::ssnr)LEN && lazy.loaded() && !lazy.failed(), "loaded on retry");
+    }
+    check(SecureString::statistics().objects == objects, "loaded string destroyed");
+    unlink(path);
+
+    if (failures == 0)
+        printf("lazy budget OK\n");
+    return failures == 0 ? 0 : 1;
+}